@@ -26,8 +26,35 @@
 #define DFTRACER_AGGREGATION_FILE "DFTRACER_AGGREGATION_FILE"
 #define DFTRACER_BIND_SIGNALS "DFTRACER_BIND_SIGNALS"
 #define DFTRACER_WRITE_BUFFER_SIZE "DFTRACER_WRITE_BUFFER_SIZE"
+#define DFTRACER_MMAP_BUFFER "DFTRACER_MMAP_BUFFER"
+#define DFTRACER_FLUSH_INTERVAL_MS "DFTRACER_FLUSH_INTERVAL_MS"
+#define DFTRACER_ROTATE_SIZE_MB "DFTRACER_ROTATE_SIZE_MB"
+#define DFTRACER_ROTATE_MINUTES "DFTRACER_ROTATE_MINUTES"
+#define DFTRACER_STAGE_DIR "DFTRACER_STAGE_DIR"
+#define DFTRACER_STAGE_DRAIN_MBPS "DFTRACER_STAGE_DRAIN_MBPS"
+#define DFTRACER_WRITER_BACKEND "DFTRACER_WRITER_BACKEND"
+#define DFTRACER_SHM_RING_MB "DFTRACER_SHM_RING_MB"
+#define DFTRACER_MPI_SHARED_FILE "DFTRACER_MPI_SHARED_FILE"
 #define DFTRACER_TRACE_INTERVAL_MS "DFTRACER_TRACE_INTERVAL_MS"
+#define DFTRACER_PAGE_CACHE_SAMPLING "DFTRACER_PAGE_CACHE_SAMPLING"
+#define DFTRACER_PAGE_CACHE_BUDGET "DFTRACER_PAGE_CACHE_BUDGET"
+#define DFTRACER_ACCESS_PATTERN "DFTRACER_ACCESS_PATTERN"
+#define DFTRACER_COUNTERS "DFTRACER_COUNTERS"
+#define DFTRACER_MIN_DURATION "DFTRACER_MIN_DURATION"
+#define DFTRACER_SAMPLING "DFTRACER_SAMPLING"
+#define DFTRACER_GOVERNOR "DFTRACER_GOVERNOR"
+#define DFTRACER_GOVERNOR_MAX_EVENTS "DFTRACER_GOVERNOR_MAX_EVENTS"
+#define DFTRACER_GOVERNOR_MAX_OVERHEAD "DFTRACER_GOVERNOR_MAX_OVERHEAD"
+#define DFTRACER_COALESCE "DFTRACER_COALESCE"
+#define DFTRACER_COALESCE_GAP_US "DFTRACER_COALESCE_GAP_US"
+#define DFTRACER_FLIGHT_RECORDER "DFTRACER_FLIGHT_RECORDER"
+#define DFTRACER_FLIGHT_SIZE_MB "DFTRACER_FLIGHT_SIZE_MB"
+#define DFTRACER_FLIGHT_TRIGGER_US "DFTRACER_FLIGHT_TRIGGER_US"
 #define DFTRACER_ALL_FILES "all"
+// <pid>:<event index> of the exec call, set by the tracer for the new image
+#define DFTRACER_PARENT_CONTEXT "DFTRACER_PARENT_CONTEXT"
+// parsed configuration published for descendants, see config_snapshot.h
+#define DFTRACER_CONFIG_SNAPSHOT "DFTRACER_CONFIG_SNAPSHOT"
 
 static const int EVENT_TYPE_SIZE = 128;
 static const unsigned int DFT_PATH_MAX = 1024 * 4;
@@ -20,6 +20,7 @@ void initialize_main(const char *log_file, const char *data_dirs,
 void initialize_no_bind(const char *log_file, const char *data_dirs,
                         int *process_id);
 void finalize();
+void dump_flight_recorder();
 #ifdef __cplusplus
 }
 #endif
@@ -64,6 +65,7 @@ class DFTracer {
 #define DFTRACER_CPP_INIT_NO_BIND(log_file, data_dirs, process_id) \
   initialize_no_bind(log_file, data_dirs, process_id);
 #define DFTRACER_CPP_FINI() finalize()
+#define DFTRACER_CPP_FLIGHT_DUMP() dump_flight_recorder()
 #define DFTRACER_CPP_FUNCTION() \
   DFTracer profiler_dft_fn =    \
       DFTracer((char *)__FUNCTION__, CPP_LOG_CATEGORY, DF_DATA_EVENT);
@@ -125,6 +127,7 @@ void update_metadata_string_type(struct DFTracerData *data, const char *key,
 #define DFTRACER_C_INIT_NO_BIND(log_file, data_dirs, process_id) \
   initialize_no_bind(log_file, data_dirs, process_id);
 #define DFTRACER_C_FINI() finalize()
+#define DFTRACER_C_FLIGHT_DUMP() dump_flight_recorder()
 
 #define DFTRACER_C_FUNCTION_START() \
   struct DFTracerData *data_fn =    \
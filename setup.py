@@ -87,6 +87,8 @@ class CMakeBuild(build_ext):
         cmake_args += [f"-DDFTRACER_ENABLE_FTRACING={enable_ftracing}"]
         enable_hip_tracing = os.environ.get("DFTRACER_ENABLE_HIP_TRACING", "OFF")
         cmake_args += [f"-DDFTRACER_ENABLE_HIP_TRACING={enable_hip_tracing}"]
+        enable_io_uring_tracing = os.environ.get("DFTRACER_ENABLE_IO_URING_TRACING", "OFF")
+        cmake_args += [f"-DDFTRACER_ENABLE_IO_URING_TRACING={enable_io_uring_tracing}"]
         enable_mpi = os.environ.get("DFTRACER_ENABLE_MPI", "OFF")
         cmake_args += [f"-DDFTRACER_ENABLE_MPI={enable_mpi}"]
         disable_hwloc = os.environ.get("DFTRACER_DISABLE_HWLOC", "ON")
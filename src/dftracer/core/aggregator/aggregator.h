@@ -101,6 +101,15 @@ class Aggregator {
       }
     }
   }
+  // in a forked child: drops the parent's aggregations, the lock may be
+  // held by a thread that does not exist in the child
+  void forked() {
+    new (&mtx) std::shared_mutex();
+    finalize();
+    aggregated_data_.clear();
+    last_interval = 0;
+    is_first = true;
+  }
   bool aggregate(AggregatedKey &aggregated_key);
   int get_previous_aggregations(AggregatedDataType &data, bool all = false);
 };
@@ -0,0 +1,49 @@
+#ifndef DFTRACER_GOTCHA_BINDING_H
+#define DFTRACER_GOTCHA_BINDING_H
+
+#include <dlfcn.h>
+#include <gotcha/gotcha.h>
+
+/**
+ * Bindings for calls that are not exposed by the brahma interface classes.
+ * The wrappers forward to the tracer instance while it is active and call the
+ * real symbol directly otherwise, so they stay safe after finalize.
+ */
+
+inline void *dft_get_wrappee(gotcha_wrappee_handle_t handle,
+                             const char *name) {
+  void *real = nullptr;
+  if (handle != nullptr) real = gotcha_get_wrappee(handle);
+  if (real == nullptr) real = dlsym(RTLD_NEXT, name);
+  return real;
+}
+
+#define DFT_GOTCHA_DECL(name, ret, args) \
+  typedef ret(*name##_dft_fptr) args;    \
+  static gotcha_wrappee_handle_t name##_dft_handle = nullptr;
+
+#define DFT_GOTCHA_BINDING(name) \
+  { #name, (void *)name##_dft_wrapper, &name##_dft_handle }
+
+// binds an ABI identical alias of name (e.g. aio_read64) to name's wrapper
+#define DFT_GOTCHA_ALIAS_DECL(alias) \
+  static gotcha_wrappee_handle_t alias##_dft_handle = nullptr;
+
+#define DFT_GOTCHA_ALIAS_BINDING(alias, name) \
+  { #alias, (void *)name##_dft_wrapper, &alias##_dft_handle }
+
+#define DFT_MAP_OR_FAIL(name) \
+  name##_dft_fptr __real_##name =   \
+      (name##_dft_fptr)dft_get_wrappee(name##_dft_handle, #name);
+
+#define DFT_GOTCHA_WRAPPER(klass, ret, name, params, args) \
+  static ret name##_dft_wrapper params {                   \
+    auto instance = klass::get_active_instance();          \
+    if (instance == nullptr) {                             \
+      DFT_MAP_OR_FAIL(name);                               \
+      return __real_##name args;                           \
+    }                                                      \
+    return instance->name args;                            \
+  }
+
+#endif  // DFTRACER_GOTCHA_BINDING_H
@@ -2,11 +2,123 @@
 // Created by hariharan on 8/16/22.
 //
 #include <cpp-logger/logger.h>
+#include <dftracer/core/brahma/gotcha_binding.h>
 #include <dftracer/core/brahma/posix.h>
 #include <dftracer/core/common/dftracer_main.h>
 
 static ConstEventNameType CATEGORY = "POSIX";
 
+DFT_GOTCHA_DECL(readv, ssize_t, (int, const struct iovec *, int));
+DFT_GOTCHA_DECL(writev, ssize_t, (int, const struct iovec *, int));
+DFT_GOTCHA_DECL(preadv, ssize_t, (int, const struct iovec *, int, off_t));
+DFT_GOTCHA_DECL(pwritev, ssize_t, (int, const struct iovec *, int, off_t));
+DFT_GOTCHA_DECL(preadv2, ssize_t, (int, const struct iovec *, int, off_t, int));
+DFT_GOTCHA_DECL(pwritev2, ssize_t,
+                (int, const struct iovec *, int, off_t, int));
+DFT_GOTCHA_DECL(copy_file_range, ssize_t,
+                (int, off64_t *, int, off64_t *, size_t, unsigned int));
+DFT_GOTCHA_DECL(sendfile, ssize_t, (int, int, off_t *, size_t));
+DFT_GOTCHA_DECL(splice, ssize_t,
+                (int, off64_t *, int, off64_t *, size_t, unsigned int));
+DFT_GOTCHA_DECL(aio_read, int, (struct aiocb *));
+DFT_GOTCHA_DECL(aio_write, int, (struct aiocb *));
+DFT_GOTCHA_DECL(lio_listio, int,
+                (int, struct aiocb *const[], int, struct sigevent *));
+DFT_GOTCHA_DECL(aio_suspend, int,
+                (const struct aiocb *const[], int, const struct timespec *));
+DFT_GOTCHA_DECL(aio_error, int, (const struct aiocb *));
+DFT_GOTCHA_DECL(aio_return, ssize_t, (struct aiocb *));
+DFT_GOTCHA_DECL(stat, int, (const char *, struct stat *));
+DFT_GOTCHA_DECL(lstat, int, (const char *, struct stat *));
+DFT_GOTCHA_DECL(fstat, int, (int, struct stat *));
+DFT_GOTCHA_DECL(fstatat, int, (int, const char *, struct stat *, int));
+DFT_GOTCHA_DECL(stat64, int, (const char *, struct stat64 *));
+DFT_GOTCHA_DECL(lstat64, int, (const char *, struct stat64 *));
+DFT_GOTCHA_DECL(fstat64, int, (int, struct stat64 *));
+DFT_GOTCHA_DECL(fstatat64, int, (int, const char *, struct stat64 *, int));
+DFT_GOTCHA_DECL(__fxstatat, int,
+                (int, int, const char *, struct stat *, int));
+DFT_GOTCHA_DECL(__fxstatat64, int,
+                (int, int, const char *, struct stat64 *, int));
+#ifdef STATX_BASIC_STATS
+DFT_GOTCHA_DECL(statx, int,
+                (int, const char *, int, unsigned int, struct statx *));
+#endif
+DFT_GOTCHA_DECL(fdopendir, DIR *, (int));
+DFT_GOTCHA_DECL(readdir, struct dirent *, (DIR *));
+DFT_GOTCHA_DECL(readdir64, struct dirent64 *, (DIR *));
+DFT_GOTCHA_DECL(getdents64, ssize_t, (int, void *, size_t));
+DFT_GOTCHA_DECL(closedir, int, (DIR *));
+DFT_GOTCHA_DECL(posix_fadvise, int, (int, off_t, off_t, int));
+DFT_GOTCHA_DECL(posix_fadvise64, int, (int, off64_t, off64_t, int));
+DFT_GOTCHA_DECL(readahead, ssize_t, (int, off64_t, size_t));
+DFT_GOTCHA_DECL(munmap, int, (void *, size_t));
+DFT_GOTCHA_DECL(msync, int, (void *, size_t, int));
+DFT_GOTCHA_DECL(madvise, int, (void *, size_t, int));
+DFT_GOTCHA_DECL(mremap, void *, (void *, size_t, size_t, int, ...));
+DFT_GOTCHA_DECL(execve, int, (const char *, char *const[], char *const[]));
+DFT_GOTCHA_DECL(execvpe, int, (const char *, char *const[], char *const[]));
+#if __WORDSIZE == 64
+DFT_GOTCHA_ALIAS_DECL(aio_read64);
+DFT_GOTCHA_ALIAS_DECL(aio_write64);
+DFT_GOTCHA_ALIAS_DECL(lio_listio64);
+DFT_GOTCHA_ALIAS_DECL(aio_suspend64);
+DFT_GOTCHA_ALIAS_DECL(aio_error64);
+DFT_GOTCHA_ALIAS_DECL(aio_return64);
+DFT_GOTCHA_ALIAS_DECL(preadv64);
+DFT_GOTCHA_ALIAS_DECL(pwritev64);
+DFT_GOTCHA_ALIAS_DECL(preadv64v2);
+DFT_GOTCHA_ALIAS_DECL(pwritev64v2);
+DFT_GOTCHA_ALIAS_DECL(sendfile64);
+#endif
+
+static inline size_t iov_bytes(const struct iovec *iov, int iovcnt) {
+  size_t count = 0;
+  if (iov == nullptr) return count;
+  for (int i = 0; i < iovcnt; ++i) count += iov[i].iov_len;
+  return count;
+}
+
+// copy of envp with DFTRACER_PARENT_CONTEXT replaced by entry; exec wrappers
+// pass it explicitly, as setenv in a vfork child or next to getenv in other
+// threads is unsafe
+static std::vector<char *> context_env(char *const envp[],
+                                       std::string &entry) {
+  std::vector<char *> env;
+  size_t length = strlen(DFTRACER_PARENT_CONTEXT);
+  for (size_t i = 0; envp != nullptr && envp[i] != nullptr; ++i) {
+    if (strncmp(envp[i], DFTRACER_PARENT_CONTEXT, length) == 0 &&
+        envp[i][length] == '=') {
+      continue;
+    }
+    env.push_back(envp[i]);
+  }
+  env.push_back(&entry[0]);
+  env.push_back(nullptr);
+  return env;
+}
+
+// removes [lo, hi) from a list of disjoint ranges, returns the bytes that
+// were covered
+static size_t subtract_range(std::vector<std::pair<off64_t, off64_t>> &ranges,
+                             off64_t lo, off64_t hi) {
+  size_t removed = 0;
+  std::vector<std::pair<off64_t, off64_t>> kept;
+  for (auto &range : ranges) {
+    off64_t start = std::max(range.first, lo);
+    off64_t end = std::min(range.second, hi);
+    if (start >= end) {
+      kept.push_back(range);
+      continue;
+    }
+    removed += end - start;
+    if (range.first < start) kept.emplace_back(range.first, start);
+    if (end < range.second) kept.emplace_back(end, range.second);
+  }
+  ranges.swap(kept);
+  return removed;
+}
+
 std::shared_ptr<brahma::POSIXDFTracer> brahma::POSIXDFTracer::instance =
     nullptr;
 bool brahma::POSIXDFTracer::stop_trace = false;
@@ -25,17 +137,50 @@ int brahma::POSIXDFTracer::open(const char *pathname, int flags, ...) {
     ret = __real_open(pathname, flags);
   }
   DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
-  DFT_LOGGER_END();
+  TimeResolution open_end = trace ? this->logger->get_time() : 0;
+  if (trace && page_cache_sampling && ret != -1) {
+    double page_cache = sample_page_cache(ret, fhash);
+    if (page_cache >= 0) {
+      DFT_LOGGER_UPDATE_TYPE(page_cache, MetadataType::MT_VALUE);
+    }
+  }
+  DFT_LOGGER_END_AT(open_end);
   if (trace) this->trace(ret, fhash);
   return ret;
 }
 
 int brahma::POSIXDFTracer::close(int fd) {
   BRAHMA_MAP_OR_FAIL(close);
+  // sampled before the event starts so the probe is not charged to close
+  double page_cache = -1;
+  if (page_cache_sampling) {
+    HashType hash = is_traced(fd, __FUNCTION__);
+    if (hash != NO_HASH_DEFAULT) page_cache = sample_page_cache(fd, hash);
+  }
   DFT_LOGGER_START(fd);
+  if (page_cache >= 0) {
+    DFT_LOGGER_UPDATE_TYPE(page_cache, MetadataType::MT_VALUE);
+  }
+  HintState hint;
+  // released even when close is not traced so a reused fd starts clean
+  if (is_hinted(fd) && hint_release(fd, hint) && trace) {
+    size_t hinted_bytes = hint.hinted_bytes;
+    size_t hinted_read_bytes = hint.hinted_read_bytes;
+    size_t hinted_reads = hint.hinted_reads;
+    size_t unhinted_reads = hint.unhinted_reads;
+    TimeResolution hinted_read_time = hint.hinted_read_time;
+    TimeResolution unhinted_read_time = hint.unhinted_read_time;
+    DFT_LOGGER_UPDATE_TYPE(hinted_bytes, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(hinted_read_bytes, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(hinted_reads, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(unhinted_reads, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(hinted_read_time, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(unhinted_read_time, MetadataType::MT_VALUE);
+  }
   int ret = __real_close(fd);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
   DFT_LOGGER_END();
+  if (trace && access_pattern) access_summary(fd, fhash);
   if (trace) this->remove_trace(fd);
   return ret;
 }
@@ -46,6 +191,8 @@ ssize_t brahma::POSIXDFTracer::write(int fd, const void *buf, size_t count) {
   DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
   ssize_t ret = __real_write(fd, buf, count);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, -1, ret);
+  if (trace && access_pattern) access_request(fd, -1, ret);
   DFT_LOGGER_END();
   return ret;
 }
@@ -56,7 +203,14 @@ ssize_t brahma::POSIXDFTracer::read(int fd, void *buf, size_t count) {
   DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
   ssize_t ret = __real_read(fd, buf, count);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
-  DFT_LOGGER_END();
+  DFT_LOGGER_UPDATE_IO(fd, -1, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, -1, ret);
+  DFT_LOGGER_END_AT(read_end);
+  // after the event so that the hint bookkeeping is not charged to it
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, -1, ret, read_end - start_time);
+  }
   return ret;
 }
 
@@ -67,6 +221,7 @@ off_t brahma::POSIXDFTracer::lseek(int fd, off_t offset, int whence) {
   DFT_LOGGER_UPDATE_TYPE(whence, MetadataType::MT_VALUE);
   ssize_t ret = __real_lseek(fd, offset, whence);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  if (trace && access_pattern) access_seek(fd, ret);
   DFT_LOGGER_END();
   return ret;
 }
@@ -96,7 +251,14 @@ int brahma::POSIXDFTracer::open64(const char *path, int flags, ...) {
     ret = __real_open64(path, flags);
   }
   DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
-  DFT_LOGGER_END();
+  TimeResolution open_end = trace ? this->logger->get_time() : 0;
+  if (trace && page_cache_sampling && ret != -1) {
+    double page_cache = sample_page_cache(ret, fhash);
+    if (page_cache >= 0) {
+      DFT_LOGGER_UPDATE_TYPE(page_cache, MetadataType::MT_VALUE);
+    }
+  }
+  DFT_LOGGER_END_AT(open_end);
   if (trace) this->trace(ret, fhash);
   return ret;
 }
@@ -108,6 +270,7 @@ off64_t brahma::POSIXDFTracer::lseek64(int fd, off64_t offset, int whence) {
   DFT_LOGGER_UPDATE_TYPE(whence, MetadataType::MT_VALUE);
   off64_t ret = __real_lseek64(fd, offset, whence);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  if (trace && access_pattern) access_seek(fd, ret);
   DFT_LOGGER_END();
   return ret;
 }
@@ -120,7 +283,13 @@ ssize_t brahma::POSIXDFTracer::pread(int fd, void *buf, size_t count,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   ssize_t ret = __real_pread(fd, buf, count, offset);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
-  DFT_LOGGER_END();
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END_AT(read_end);
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, offset, ret, read_end - start_time);
+  }
   return ret;
 }
 
@@ -132,7 +301,13 @@ ssize_t brahma::POSIXDFTracer::pread64(int fd, void *buf, size_t count,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   ssize_t ret = __real_pread64(fd, buf, count, offset);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
-  DFT_LOGGER_END();
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END_AT(read_end);
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, offset, ret, read_end - start_time);
+  }
   return ret;
 }
 
@@ -144,6 +319,8 @@ ssize_t brahma::POSIXDFTracer::pwrite(int fd, const void *buf, size_t count,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   ssize_t ret = __real_pwrite(fd, buf, count, offset);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  if (trace && access_pattern) access_request(fd, offset, ret);
   DFT_LOGGER_END();
   return ret;
 }
@@ -156,6 +333,8 @@ ssize_t brahma::POSIXDFTracer::pwrite64(int fd, const void *buf, size_t count,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   ssize_t ret = __real_pwrite64(fd, buf, count, offset);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  if (trace && access_pattern) access_request(fd, offset, ret);
   DFT_LOGGER_END();
   return ret;
 }
@@ -208,6 +387,13 @@ void *brahma::POSIXDFTracer::mmap(void *addr, size_t length, int prot,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   void *ret = __real_mmap(addr, length, prot, flags, fd, offset);
   DFT_LOGGER_END();
+  if (ret != MAP_FAILED) {
+    // an untraced mapping still replaces what was tracked at its address
+    if (trace)
+      map_region_add(ret, length, fhash, offset);
+    else
+      map_region_remove(ret, length);
+  }
   return ret;
 }
 
@@ -220,6 +406,13 @@ void *brahma::POSIXDFTracer::mmap64(void *addr, size_t length, int prot,
   DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
   void *ret = __real_mmap64(addr, length, prot, flags, fd, offset);
   DFT_LOGGER_END();
+  if (ret != MAP_FAILED) {
+    // an untraced mapping still replaces what was tracked at its address
+    if (trace)
+      map_region_add(ret, length, fhash, offset);
+    else
+      map_region_remove(ret, length);
+  }
   return ret;
 }
 
@@ -431,6 +624,7 @@ DIR *brahma::POSIXDFTracer::opendir(const char *name) {
   DFT_LOGGER_START(name);
   DIR *ret = __real_opendir(name);
   DFT_LOGGER_END();
+  if (trace && ret != nullptr) dir_scan_begin(ret, fhash, start_time);
   return ret;
 }
 
@@ -550,34 +744,45 @@ int brahma::POSIXDFTracer::ftruncate(int fd, off_t length) {
 }
 
 int brahma::POSIXDFTracer::execl(const char *pathname, const char *arg, ...) {
-  BRAHMA_MAP_OR_FAIL(execl);
+  DFT_MAP_OR_FAIL(execve);
   DFT_LOGGER_START_ALWAYS();
   DFT_LOGGER_UPDATE_HASH(pathname);
   DFT_LOGGER_UPDATE_HASH(arg);
+  std::vector<char *> argv = {const_cast<char *>(arg)};
   va_list args;
   va_start(args, arg);
-  int ret = __real_execl(pathname, arg, args);
+  while (argv.back() != nullptr) argv.push_back(va_arg(args, char *));
   va_end(args);
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(environ, context);
+  int ret = __real_execve(pathname, argv.data(), env.data());
+  DFT_LOGGER_UPDATE(ret);
   DFT_LOGGER_END();
   return ret;
 }
 
 int brahma::POSIXDFTracer::execlp(const char *pathname, const char *arg, ...) {
-  BRAHMA_MAP_OR_FAIL(execlp);
+  DFT_MAP_OR_FAIL(execvpe);
   DFT_LOGGER_START_ALWAYS();
   DFT_LOGGER_UPDATE_HASH(pathname);
   DFT_LOGGER_UPDATE_HASH(arg);
+  std::vector<char *> argv = {const_cast<char *>(arg)};
   va_list args;
   va_start(args, arg);
-  int ret = __real_execlp(pathname, arg, args);
+  while (argv.back() != nullptr) argv.push_back(va_arg(args, char *));
   va_end(args);
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(environ, context);
+  int ret = __real_execvpe(pathname, argv.data(), env.data());
   DFT_LOGGER_UPDATE(ret);
   DFT_LOGGER_END();
   return ret;
 }
 
 int brahma::POSIXDFTracer::execv(const char *pathname, char *const argv[]) {
-  BRAHMA_MAP_OR_FAIL(execv);
+  DFT_MAP_OR_FAIL(execve);
   DFT_LOGGER_START_ALWAYS();
   DFT_LOGGER_UPDATE_HASH(pathname);
   const char *val = argv[0];
@@ -607,15 +812,17 @@ int brahma::POSIXDFTracer::execv(const char *pathname, char *const argv[]) {
     i++;
     val = argv[i];
   }
-
-  int ret = __real_execv(pathname, argv);
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(environ, context);
+  int ret = __real_execve(pathname, argv, env.data());
   DFT_LOGGER_UPDATE(ret);
   DFT_LOGGER_END();
   return ret;
 }
 
 int brahma::POSIXDFTracer::execvp(const char *pathname, char *const argv[]) {
-  BRAHMA_MAP_OR_FAIL(execvp);
+  DFT_MAP_OR_FAIL(execvpe);
   DFT_LOGGER_START_ALWAYS();
   DFT_LOGGER_UPDATE_HASH(pathname);
   const char *val = argv[0];
@@ -645,7 +852,10 @@ int brahma::POSIXDFTracer::execvp(const char *pathname, char *const argv[]) {
     i++;
     val = argv[i];
   }
-  int ret = __real_execvp(pathname, argv);
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(environ, context);
+  int ret = __real_execvpe(pathname, argv, env.data());
   DFT_LOGGER_UPDATE(ret);
   DFT_LOGGER_END();
   return ret;
@@ -683,7 +893,51 @@ int brahma::POSIXDFTracer::execvpe(const char *pathname, char *const argv[],
     i++;
     val = argv[i];
   }
-  int ret = __real_execvpe(pathname, argv, envp);
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(envp, context);
+  int ret = __real_execvpe(pathname, argv, env.data());
+  DFT_LOGGER_UPDATE(ret);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::execve(const char *pathname, char *const argv[],
+                                  char *const envp[]) {
+  DFT_MAP_OR_FAIL(execve);
+  DFT_LOGGER_START_ALWAYS();
+  DFT_LOGGER_UPDATE_HASH(pathname);
+  const char *val = argv[0];
+  int i = 0;
+  while (val != NULL) {
+    if (i == 0) {
+      const char *arg0 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg0);
+    } else if (i == 1) {
+      const char *arg1 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg1);
+    } else if (i == 2) {
+      const char *arg2 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg2);
+    } else if (i == 3) {
+      const char *arg3 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg3);
+    } else if (i == 4) {
+      const char *arg4 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg4);
+    } else if (i == 5) {
+      const char *arg5 = argv[i];
+      DFT_LOGGER_UPDATE_HASH(arg5);
+    } else {
+      break;
+    }
+    i++;
+    val = argv[i];
+  }
+  std::string context = std::string(DFTRACER_PARENT_CONTEXT) + "=" +
+                        this->logger->parent_context();
+  auto env = context_env(envp, context);
+  int ret = __real_execve(pathname, argv, env.data());
   DFT_LOGGER_UPDATE(ret);
   DFT_LOGGER_END();
   return ret;
@@ -691,17 +945,17 @@ int brahma::POSIXDFTracer::execvpe(const char *pathname, char *const argv[],
 
 int brahma::POSIXDFTracer::fork() {
   BRAHMA_MAP_OR_FAIL(fork);
+  // the pthread_atfork handlers registered by DFTracerCore flush the parent
+  // and give the child its own trace, whose start event points at this one
+  DFT_LOGGER_START_ALWAYS();
   int ret = __real_fork();
   if (ret == 0) {
-    // zero comes for forked childs
-    auto main = dftracer::Singleton<dftracer::DFTracerCore>::get_instance(
-        ProfilerStage::PROFILER_INIT, ProfileType::PROFILER_PRELOAD);
-    main->reinitialize();
-  } else {
-    DFT_LOGGER_START_ALWAYS();
-    DFT_LOGGER_UPDATE(ret);
-    DFT_LOGGER_END();
+    delete metadata;
+    this->logger->exit_event();
+    return ret;
   }
+  DFT_LOGGER_UPDATE(ret);
+  DFT_LOGGER_END();
   return ret;
 }
 
@@ -718,3 +972,1230 @@ void brahma::POSIXDFTracer::_exit(int status) {
   dft_finalize(true);
   __real__exit(status);
 }
+
+ssize_t brahma::POSIXDFTracer::readv(int fd, const struct iovec *iov,
+                                     int iovcnt) {
+  DFT_MAP_OR_FAIL(readv);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  ssize_t ret = __real_readv(fd, iov, iovcnt);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, -1, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, -1, ret);
+  DFT_LOGGER_END_AT(read_end);
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, -1, ret, read_end - start_time);
+  }
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::writev(int fd, const struct iovec *iov,
+                                      int iovcnt) {
+  DFT_MAP_OR_FAIL(writev);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  ssize_t ret = __real_writev(fd, iov, iovcnt);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, -1, ret);
+  if (trace && access_pattern) access_request(fd, -1, ret);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::preadv(int fd, const struct iovec *iov,
+                                      int iovcnt, off_t offset) {
+  DFT_MAP_OR_FAIL(preadv);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  ssize_t ret = __real_preadv(fd, iov, iovcnt, offset);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END_AT(read_end);
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, offset, ret, read_end - start_time);
+  }
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::pwritev(int fd, const struct iovec *iov,
+                                       int iovcnt, off_t offset) {
+  DFT_MAP_OR_FAIL(pwritev);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  ssize_t ret = __real_pwritev(fd, iov, iovcnt, offset);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::preadv2(int fd, const struct iovec *iov,
+                                       int iovcnt, off_t offset, int flags) {
+  DFT_MAP_OR_FAIL(preadv2);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  ssize_t ret = __real_preadv2(fd, iov, iovcnt, offset, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  TimeResolution read_end = trace ? this->logger->get_time() : 0;
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END_AT(read_end);
+  if (trace && is_hinted(fd)) {
+    hint_observe(fd, offset, ret, read_end - start_time);
+  }
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::pwritev2(int fd, const struct iovec *iov,
+                                        int iovcnt, off_t offset, int flags) {
+  DFT_MAP_OR_FAIL(pwritev2);
+  DFT_LOGGER_START(fd);
+  size_t count = trace ? iov_bytes(iov, iovcnt) : 0;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(iovcnt, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  ssize_t ret = __real_pwritev2(fd, iov, iovcnt, offset, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_IO(fd, offset, ret);
+  if (trace && access_pattern) access_request(fd, offset, ret);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::copy_file_range(int fd_in, off64_t *off_in,
+                                               int fd_out, off64_t *off_out,
+                                               size_t len, unsigned int flags) {
+  DFT_MAP_OR_FAIL(copy_file_range);
+  HashType fhash_in = is_traced(fd_in, __FUNCTION__);
+  HashType fhash_out = is_traced(fd_out, __FUNCTION__);
+  DFT_LOGGER_START_HASH(fhash_in != NO_HASH_DEFAULT ? fhash_in : fhash_out);
+  if (fhash_in != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_in);
+  }
+  if (fhash_out != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_out);
+  }
+  if (off_in != nullptr) {
+    off64_t offset_in = *off_in;
+    DFT_LOGGER_UPDATE_TYPE(offset_in, MetadataType::MT_VALUE);
+  }
+  if (off_out != nullptr) {
+    off64_t offset_out = *off_out;
+    DFT_LOGGER_UPDATE_TYPE(offset_out, MetadataType::MT_VALUE);
+  }
+  size_t count = len;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  ssize_t ret = __real_copy_file_range(fd_in, off_in, fd_out, off_out, len,
+                                       flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::sendfile(int out_fd, int in_fd, off_t *offset,
+                                        size_t count) {
+  DFT_MAP_OR_FAIL(sendfile);
+  HashType fhash_in = is_traced(in_fd, __FUNCTION__);
+  HashType fhash_out = is_traced(out_fd, __FUNCTION__);
+  DFT_LOGGER_START_HASH(fhash_in != NO_HASH_DEFAULT ? fhash_in : fhash_out);
+  if (fhash_in != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_in);
+  }
+  if (fhash_out != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_out);
+  }
+  if (offset != nullptr) {
+    off_t offset_in = *offset;
+    DFT_LOGGER_UPDATE_TYPE(offset_in, MetadataType::MT_VALUE);
+  }
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  ssize_t ret = __real_sendfile(out_fd, in_fd, offset, count);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::splice(int fd_in, off64_t *off_in, int fd_out,
+                                      off64_t *off_out, size_t len,
+                                      unsigned int flags) {
+  DFT_MAP_OR_FAIL(splice);
+  HashType fhash_in = is_traced(fd_in, __FUNCTION__);
+  HashType fhash_out = is_traced(fd_out, __FUNCTION__);
+  DFT_LOGGER_START_HASH(fhash_in != NO_HASH_DEFAULT ? fhash_in : fhash_out);
+  if (fhash_in != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_in);
+  }
+  if (fhash_out != NO_HASH_DEFAULT) {
+    DFT_LOGGER_UPDATE(fhash_out);
+  }
+  if (off_in != nullptr) {
+    off64_t offset_in = *off_in;
+    DFT_LOGGER_UPDATE_TYPE(offset_in, MetadataType::MT_VALUE);
+  }
+  if (off_out != nullptr) {
+    off64_t offset_out = *off_out;
+    DFT_LOGGER_UPDATE_TYPE(offset_out, MetadataType::MT_VALUE);
+  }
+  size_t count = len;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  ssize_t ret = __real_splice(fd_in, off_in, fd_out, off_out, len, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+void brahma::POSIXDFTracer::aio_begin(const void *aiocbp, HashType hash,
+                                      int opcode, size_t count, off64_t offset,
+                                      TimeResolution start_time) {
+  PendingAIO pending;
+  pending.fhash = hash;
+  pending.name = opcode == LIO_WRITE ? "aio_write_async" : "aio_read_async";
+  pending.start_time = start_time;
+  pending.end_time = 0;
+  pending.count = count;
+  pending.offset = offset;
+  std::lock_guard<std::mutex> lock(aio_mtx);
+  if (pending_aio.size() >= MAX_PENDING_AIO) {
+    DFTRACER_LOG_WARN("POSIXDFTracer dropping aiocb with %lu pending",
+                      pending_aio.size());
+    return;
+  }
+  pending_aio.insert_or_assign(aiocbp, pending);
+}
+
+HashType brahma::POSIXDFTracer::aio_pending_hash(const void *aiocbp) {
+  std::lock_guard<std::mutex> lock(aio_mtx);
+  auto iter = pending_aio.find(aiocbp);
+  if (iter == pending_aio.end()) return NO_HASH_DEFAULT;
+  return iter->second.fhash;
+}
+
+void brahma::POSIXDFTracer::aio_complete(const void *aiocbp) {
+  std::lock_guard<std::mutex> lock(aio_mtx);
+  auto iter = pending_aio.find(aiocbp);
+  if (iter != pending_aio.end() && iter->second.end_time == 0) {
+    iter->second.end_time = logger->get_time();
+  }
+}
+
+void brahma::POSIXDFTracer::aio_end(const void *aiocbp, ssize_t ret) {
+  PendingAIO pending;
+  {
+    std::lock_guard<std::mutex> lock(aio_mtx);
+    auto iter = pending_aio.find(aiocbp);
+    if (iter == pending_aio.end()) return;
+    pending = iter->second;
+    pending_aio.erase(iter);
+  }
+  if (pending.end_time == 0) pending.end_time = logger->get_time();
+  dftracer::Metadata *metadata = nullptr;
+  if (logger->include_metadata) {
+    metadata = new dftracer::Metadata();
+    metadata->insert_or_assign("fhash", pending.fhash);
+    metadata->insert_or_assign("count", pending.count, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("offset", pending.offset,
+                               MetadataType::MT_VALUE);
+    unsigned long aiocb = (unsigned long)aiocbp;
+    metadata->insert_or_assign("aiocb", aiocb, MetadataType::MT_IGNORE);
+    metadata->insert_or_assign("ret", ret, MetadataType::MT_VALUE);
+  }
+  logger->enter_event();
+  logger->log(pending.name, CATEGORY, pending.start_time,
+              pending.end_time - pending.start_time, metadata);
+  logger->exit_event();
+}
+
+int brahma::POSIXDFTracer::aio_read(struct aiocb *aiocbp) {
+  DFT_MAP_OR_FAIL(aio_read);
+  DFT_LOGGER_START(aiocbp->aio_fildes);
+  size_t count = aiocbp->aio_nbytes;
+  off64_t offset = aiocbp->aio_offset;
+  unsigned long aiocb = (unsigned long)aiocbp;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(aiocb, MetadataType::MT_IGNORE);
+  int ret = __real_aio_read(aiocbp);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace && ret == 0)
+    aio_begin(aiocbp, fhash, LIO_READ, count, offset, start_time);
+  return ret;
+}
+
+int brahma::POSIXDFTracer::aio_write(struct aiocb *aiocbp) {
+  DFT_MAP_OR_FAIL(aio_write);
+  DFT_LOGGER_START(aiocbp->aio_fildes);
+  size_t count = aiocbp->aio_nbytes;
+  off64_t offset = aiocbp->aio_offset;
+  unsigned long aiocb = (unsigned long)aiocbp;
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(aiocb, MetadataType::MT_IGNORE);
+  int ret = __real_aio_write(aiocbp);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace && ret == 0)
+    aio_begin(aiocbp, fhash, LIO_WRITE, count, offset, start_time);
+  return ret;
+}
+
+int brahma::POSIXDFTracer::lio_listio(int mode,
+                                      struct aiocb *const aiocb_list[],
+                                      int nitems, struct sigevent *sevp) {
+  DFT_MAP_OR_FAIL(lio_listio);
+  std::vector<HashType> hashes(nitems > 0 ? nitems : 0, NO_HASH_DEFAULT);
+  HashType list_hash = NO_HASH_DEFAULT;
+  size_t count = 0;
+  for (int i = 0; i < nitems; ++i) {
+    const struct aiocb *cb = aiocb_list[i];
+    if (cb == nullptr || cb->aio_lio_opcode == LIO_NOP) continue;
+    hashes[i] = is_traced(cb->aio_fildes, __FUNCTION__);
+    if (hashes[i] == NO_HASH_DEFAULT) continue;
+    if (list_hash == NO_HASH_DEFAULT) list_hash = hashes[i];
+    count += cb->aio_nbytes;
+  }
+  DFT_LOGGER_START_HASH(list_hash);
+  DFT_LOGGER_UPDATE_TYPE(mode, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(nitems, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  int ret = __real_lio_listio(mode, aiocb_list, nitems, sevp);
+  int err = errno;
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  // EIO means some of the requests were queued and others failed
+  if (trace && (ret == 0 || err == EIO)) {
+    for (int i = 0; i < nitems; ++i) {
+      if (hashes[i] == NO_HASH_DEFAULT) continue;
+      const struct aiocb *cb = aiocb_list[i];
+      aio_begin(cb, hashes[i], cb->aio_lio_opcode, cb->aio_nbytes,
+                cb->aio_offset, start_time);
+      if (mode == LIO_WAIT) aio_complete(cb);
+    }
+  }
+  errno = err;
+  return ret;
+}
+
+int brahma::POSIXDFTracer::aio_suspend(const struct aiocb *const aiocb_list[],
+                                       int nitems,
+                                       const struct timespec *timeout) {
+  DFT_MAP_OR_FAIL(aio_suspend);
+  HashType list_hash = NO_HASH_DEFAULT;
+  for (int i = 0; i < nitems && list_hash == NO_HASH_DEFAULT; ++i) {
+    if (aiocb_list[i] != nullptr) list_hash = aio_pending_hash(aiocb_list[i]);
+  }
+  DFT_LOGGER_START_HASH(list_hash);
+  DFT_LOGGER_UPDATE_TYPE(nitems, MetadataType::MT_VALUE);
+  int ret = __real_aio_suspend(aiocb_list, nitems, timeout);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace) {
+    DFT_MAP_OR_FAIL(aio_error);
+    for (int i = 0; i < nitems; ++i) {
+      const struct aiocb *cb = aiocb_list[i];
+      if (cb != nullptr && __real_aio_error(cb) != EINPROGRESS) {
+        aio_complete(cb);
+      }
+    }
+  }
+  return ret;
+}
+
+int brahma::POSIXDFTracer::aio_error(const struct aiocb *aiocbp) {
+  DFT_MAP_OR_FAIL(aio_error);
+  // polled in tight loops, so only the completion is recorded
+  int ret = __real_aio_error(aiocbp);
+  if (ret != EINPROGRESS) aio_complete(aiocbp);
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::aio_return(struct aiocb *aiocbp) {
+  DFT_MAP_OR_FAIL(aio_return);
+  DFT_LOGGER_START_HASH(aio_pending_hash(aiocbp));
+  unsigned long aiocb = (unsigned long)aiocbp;
+  DFT_LOGGER_UPDATE_TYPE(aiocb, MetadataType::MT_IGNORE);
+  ssize_t ret = __real_aio_return(aiocbp);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace) aio_end(aiocbp, ret);
+  return ret;
+}
+
+int brahma::POSIXDFTracer::stat(const char *path, struct stat *buf) {
+  DFT_MAP_OR_FAIL(stat);
+  DFT_LOGGER_START(path);
+  int ret = __real_stat(path, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::lstat(const char *path, struct stat *buf) {
+  DFT_MAP_OR_FAIL(lstat);
+  DFT_LOGGER_START(path);
+  int ret = __real_lstat(path, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::fstat(int fd, struct stat *buf) {
+  DFT_MAP_OR_FAIL(fstat);
+  DFT_LOGGER_START(fd);
+  int ret = __real_fstat(fd, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::fstatat(int dirfd, const char *path,
+                                   struct stat *buf, int flags) {
+  DFT_MAP_OR_FAIL(fstatat);
+  DFT_LOGGER_START_HASH(is_traced_at(dirfd, path, flags, __FUNCTION__));
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  int ret = __real_fstatat(dirfd, path, buf, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::stat64(const char *path, struct stat64 *buf) {
+  DFT_MAP_OR_FAIL(stat64);
+  DFT_LOGGER_START(path);
+  int ret = __real_stat64(path, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::lstat64(const char *path, struct stat64 *buf) {
+  DFT_MAP_OR_FAIL(lstat64);
+  DFT_LOGGER_START(path);
+  int ret = __real_lstat64(path, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::fstat64(int fd, struct stat64 *buf) {
+  DFT_MAP_OR_FAIL(fstat64);
+  DFT_LOGGER_START(fd);
+  int ret = __real_fstat64(fd, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::fstatat64(int dirfd, const char *path,
+                                     struct stat64 *buf, int flags) {
+  DFT_MAP_OR_FAIL(fstatat64);
+  DFT_LOGGER_START_HASH(is_traced_at(dirfd, path, flags, __FUNCTION__));
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  int ret = __real_fstatat64(dirfd, path, buf, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::__fxstatat(int vers, int dirfd, const char *path,
+                                      struct stat *buf, int flags) {
+  DFT_MAP_OR_FAIL(__fxstatat);
+  DFT_LOGGER_START_HASH(is_traced_at(dirfd, path, flags, __FUNCTION__));
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  int ret = __real___fxstatat(vers, dirfd, path, buf, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::__fxstatat64(int vers, int dirfd, const char *path,
+                                        struct stat64 *buf, int flags) {
+  DFT_MAP_OR_FAIL(__fxstatat64);
+  DFT_LOGGER_START_HASH(is_traced_at(dirfd, path, flags, __FUNCTION__));
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  int ret = __real___fxstatat64(vers, dirfd, path, buf, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+#ifdef STATX_BASIC_STATS
+int brahma::POSIXDFTracer::statx(int dirfd, const char *path, int flags,
+                                 unsigned int mask, struct statx *buf) {
+  DFT_MAP_OR_FAIL(statx);
+  DFT_LOGGER_START_HASH(is_traced_at(dirfd, path, flags, __FUNCTION__));
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(mask, MetadataType::MT_VALUE);
+  int ret = __real_statx(dirfd, path, flags, mask, buf);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+#endif
+
+void brahma::POSIXDFTracer::dir_scan_begin(const void *dirp, HashType hash,
+                                           TimeResolution open_time) {
+  DirScan scan;
+  scan.fhash = hash;
+  scan.open_time = open_time;
+  scan.read_time = 0;
+  scan.calls = 0;
+  scan.entries = 0;
+  scan.bytes = 0;
+  std::lock_guard<std::mutex> lock(dir_mtx);
+  if (dir_scans.size() >= MAX_DIR_SCANS) {
+    DFTRACER_LOG_WARN("POSIXDFTracer dropping directory with %lu open",
+                      dir_scans.size());
+    return;
+  }
+  if (dir_scans.insert_or_assign(dirp, scan).second) num_dir_scans++;
+}
+
+// streams of untraced directories, or any stream while none is traced,
+// are read without timing
+bool brahma::POSIXDFTracer::dir_scan_tracked(const void *dirp) {
+  if (num_dir_scans.load(std::memory_order_relaxed) == 0) return false;
+  std::lock_guard<std::mutex> lock(dir_mtx);
+  return dir_scans.find(dirp) != dir_scans.end();
+}
+
+void brahma::POSIXDFTracer::dir_scan_add(const void *dirp, size_t bytes,
+                                         TimeResolution elapsed) {
+  std::lock_guard<std::mutex> lock(dir_mtx);
+  auto iter = dir_scans.find(dirp);
+  if (iter == dir_scans.end()) return;
+  iter->second.calls++;
+  iter->second.read_time += elapsed;
+  if (bytes > 0) {
+    iter->second.entries++;
+    iter->second.bytes += bytes;
+  }
+}
+
+bool brahma::POSIXDFTracer::dir_scan_end(const void *dirp, DirScan &scan) {
+  std::lock_guard<std::mutex> lock(dir_mtx);
+  auto iter = dir_scans.find(dirp);
+  if (iter == dir_scans.end()) return false;
+  scan = iter->second;
+  dir_scans.erase(iter);
+  num_dir_scans--;
+  return true;
+}
+
+// bytes of a mapped range resident in page cache; ranges larger than the
+// windows used for files are estimated from the same windows so that
+// mincore cost does not grow with the mapping
+size_t brahma::POSIXDFTracer::resident_bytes(uintptr_t start, size_t length) {
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t max_probe = PAGE_CACHE_WINDOWS * PAGE_CACHE_WINDOW_PAGES;
+  size_t pages = (length + page_size - 1) / page_size;
+  unsigned char vec[max_probe];
+  size_t probed = 0;
+  if (pages <= max_probe) {
+    if (pages > 0 && df_mincore((void *)start, pages * page_size, vec) == 0)
+      probed = pages;
+  } else {
+    for (size_t w = 0; w < PAGE_CACHE_WINDOWS; ++w) {
+      size_t first = w * (pages - PAGE_CACHE_WINDOW_PAGES) /
+                     (PAGE_CACHE_WINDOWS - 1);
+      if (df_mincore((char *)start + first * page_size,
+                     PAGE_CACHE_WINDOW_PAGES * page_size, vec + probed) != 0)
+        break;
+      probed += PAGE_CACHE_WINDOW_PAGES;
+    }
+  }
+  if (probed == 0) return 0;
+  size_t resident = 0;
+  for (size_t i = 0; i < probed; ++i) resident += vec[i] & 1;
+  return (size_t)((double)resident * pages / probed) * page_size;
+}
+
+double brahma::POSIXDFTracer::sample_page_cache(int fd, HashType hash) {
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  struct stat st;
+  if (df_fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    return -1;
+  }
+  size_t file_pages = (st.st_size + page_size - 1) / page_size;
+  const size_t max_probe = PAGE_CACHE_WINDOWS * PAGE_CACHE_WINDOW_PAGES;
+  size_t probe = std::min(file_pages, max_probe);
+  {
+    std::lock_guard<std::mutex> lock(page_cache_mtx);
+    size_t &probed = page_cache_probed[hash];
+    if (probed + probe > page_cache_budget) return -1;
+    probed += probe;
+  }
+  // write-only descriptors cannot be mapped and are skipped
+  void *base = df_mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) return -1;
+  unsigned char vec[max_probe];
+  size_t resident = 0;
+  size_t probed = 0;
+  if (file_pages <= max_probe) {
+    if (df_mincore(base, st.st_size, vec) == 0) probed = file_pages;
+  } else {
+    for (size_t w = 0; w < PAGE_CACHE_WINDOWS; ++w) {
+      size_t first = w * (file_pages - PAGE_CACHE_WINDOW_PAGES) /
+                     (PAGE_CACHE_WINDOWS - 1);
+      if (df_mincore((char *)base + first * page_size,
+                     PAGE_CACHE_WINDOW_PAGES * page_size, vec + probed) != 0)
+        break;
+      probed += PAGE_CACHE_WINDOW_PAGES;
+    }
+  }
+  df_munmap(base, st.st_size);
+  if (probed == 0) return -1;
+  for (size_t i = 0; i < probed; ++i) resident += vec[i] & 1;
+  return (double)resident / probed;
+}
+
+DIR *brahma::POSIXDFTracer::fdopendir(int fd) {
+  DFT_MAP_OR_FAIL(fdopendir);
+  DFT_LOGGER_START(fd);
+  DIR *ret = __real_fdopendir(fd);
+  DFT_LOGGER_END();
+  if (trace && ret != nullptr) dir_scan_begin(ret, fhash, start_time);
+  return ret;
+}
+
+struct dirent *brahma::POSIXDFTracer::readdir(DIR *dirp) {
+  DFT_MAP_OR_FAIL(readdir);
+  if (!dir_scan_tracked(dirp)) return __real_readdir(dirp);
+  TimeResolution start_time = logger->get_time();
+  struct dirent *ret = __real_readdir(dirp);
+  dir_scan_add(dirp, ret != nullptr ? ret->d_reclen : 0,
+               logger->get_time() - start_time);
+  return ret;
+}
+
+struct dirent64 *brahma::POSIXDFTracer::readdir64(DIR *dirp) {
+  DFT_MAP_OR_FAIL(readdir64);
+  if (!dir_scan_tracked(dirp)) return __real_readdir64(dirp);
+  TimeResolution start_time = logger->get_time();
+  struct dirent64 *ret = __real_readdir64(dirp);
+  dir_scan_add(dirp, ret != nullptr ? ret->d_reclen : 0,
+               logger->get_time() - start_time);
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::getdents64(int fd, void *dirp, size_t count) {
+  DFT_MAP_OR_FAIL(getdents64);
+  DFT_LOGGER_START(fd);
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  ssize_t ret = __real_getdents64(fd, dirp, count);
+  if (trace && ret > 0) {
+    // the kernel's linux_dirent64 records share the layout of dirent64
+    size_t entries = 0;
+    for (ssize_t pos = 0; pos < ret; ++entries) {
+      pos += ((struct dirent64 *)((char *)dirp + pos))->d_reclen;
+    }
+    DFT_LOGGER_UPDATE_TYPE(entries, MetadataType::MT_VALUE);
+  }
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::closedir(DIR *dirp) {
+  DFT_MAP_OR_FAIL(closedir);
+  DirScan scan;
+  bool found = dir_scan_end(dirp, scan);
+  DFT_LOGGER_START_HASH(found ? scan.fhash : NO_HASH_DEFAULT);
+  int ret = __real_closedir(dirp);
+  if (trace) {
+    size_t entries = scan.entries;
+    size_t bytes = scan.bytes;
+    size_t readdir_calls = scan.calls;
+    TimeResolution readdir_time = scan.read_time;
+    TimeResolution scan_time = start_time - scan.open_time;
+    DFT_LOGGER_UPDATE_TYPE(entries, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(bytes, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(readdir_calls, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(readdir_time, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(scan_time, MetadataType::MT_VALUE);
+  }
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+// a new mapping replaces whatever was tracked in its range, as a MAP_FIXED
+// mapping silently unmaps what it lands on
+void brahma::POSIXDFTracer::map_region_add(void *addr, size_t length,
+                                           HashType hash, off64_t offset) {
+  MappedRegion region;
+  region.end = (uintptr_t)addr + length;
+  region.fhash = hash;
+  region.offset = offset;
+  region.resident = resident_bytes((uintptr_t)addr, length);
+  std::lock_guard<std::mutex> lock(map_mtx);
+  map_region_clear((uintptr_t)addr, region.end);
+  if (mapped_regions.size() >= MAX_MAPPED_REGIONS) {
+    DFTRACER_LOG_WARN("POSIXDFTracer dropping mapping with %lu live",
+                      mapped_regions.size());
+  } else {
+    mapped_regions.insert_or_assign((uintptr_t)addr, region);
+    mapped_bytes += length;
+  }
+  num_mapped_regions.store(mapped_regions.size(), std::memory_order_relaxed);
+}
+
+HashType brahma::POSIXDFTracer::map_region_find(const void *addr,
+                                                off64_t &offset) {
+  if (num_mapped_regions.load(std::memory_order_relaxed) == 0)
+    return NO_HASH_DEFAULT;
+  uintptr_t pos = (uintptr_t)addr;
+  std::lock_guard<std::mutex> lock(map_mtx);
+  auto iter = mapped_regions.upper_bound(pos);
+  if (iter == mapped_regions.begin()) return NO_HASH_DEFAULT;
+  --iter;
+  if (pos >= iter->second.end) return NO_HASH_DEFAULT;
+  offset = iter->second.offset + (pos - iter->first);
+  return iter->second.fhash;
+}
+
+brahma::POSIXDFTracer::MapRelease brahma::POSIXDFTracer::map_region_sample(
+    void *addr, size_t length) {
+  MapRelease release;
+  release.fhash = NO_HASH_DEFAULT;
+  release.unmapped = 0;
+  release.resident = 0;
+  release.resident_delta = 0;
+  release.mapped = 0;
+  if (num_mapped_regions.load(std::memory_order_relaxed) == 0) return release;
+  uintptr_t start = (uintptr_t)addr;
+  uintptr_t end = start + length;
+  std::lock_guard<std::mutex> lock(map_mtx);
+  auto iter = mapped_regions.upper_bound(start);
+  if (iter != mapped_regions.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->second.end > start) iter = prev;
+  }
+  for (; iter != mapped_regions.end() && iter->first < end; ++iter) {
+    const MappedRegion &region = iter->second;
+    uintptr_t lo = std::max(iter->first, start);
+    uintptr_t hi = std::min(region.end, end);
+    size_t overlap = hi - lo;
+    // residency at map time is only known per region, so the unmapped part
+    // is charged its proportional share of it
+    size_t baseline = (size_t)((double)region.resident * overlap /
+                               (region.end - iter->first));
+    size_t resident = resident_bytes(lo, overlap);
+    if (release.fhash == NO_HASH_DEFAULT) release.fhash = region.fhash;
+    release.unmapped += overlap;
+    release.resident += resident;
+    release.resident_delta += (long)resident - (long)baseline;
+  }
+  release.mapped = mapped_bytes - release.unmapped;
+  return release;
+}
+
+// only once the call succeeded, as a failed call leaves the range mapped
+void brahma::POSIXDFTracer::map_region_remove(void *addr, size_t length) {
+  if (num_mapped_regions.load(std::memory_order_relaxed) == 0) return;
+  std::lock_guard<std::mutex> lock(map_mtx);
+  map_region_clear((uintptr_t)addr, (uintptr_t)addr + length);
+  num_mapped_regions.store(mapped_regions.size(), std::memory_order_relaxed);
+}
+
+void brahma::POSIXDFTracer::map_region_clear(uintptr_t start, uintptr_t end) {
+  auto iter = mapped_regions.upper_bound(start);
+  if (iter != mapped_regions.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->second.end > start) iter = prev;
+  }
+  while (iter != mapped_regions.end() && iter->first < end) {
+    uintptr_t region_start = iter->first;
+    MappedRegion region = iter->second;
+    uintptr_t lo = std::max(region_start, start);
+    uintptr_t hi = std::min(region.end, end);
+    size_t region_length = region.end - region_start;
+    size_t overlap = hi - lo;
+    size_t baseline =
+        (size_t)((double)region.resident * overlap / region_length);
+    iter = mapped_regions.erase(iter);
+    mapped_bytes -= overlap;
+    size_t remaining = region.resident - baseline;
+    size_t left_resident = 0;
+    if (lo > region_start) {
+      MappedRegion left = region;
+      left.end = lo;
+      left_resident = (size_t)((double)remaining * (lo - region_start) /
+                               (region_length - overlap));
+      left.resident = left_resident;
+      mapped_regions.insert_or_assign(region_start, left);
+    }
+    if (hi < region.end) {
+      MappedRegion right = region;
+      right.offset += hi - region_start;
+      right.resident = remaining - left_resident;
+      mapped_regions.insert_or_assign(hi, right);
+    }
+  }
+}
+
+void brahma::POSIXDFTracer::map_region_move(void *old_address,
+                                            size_t old_size,
+                                            void *new_address,
+                                            size_t new_size) {
+  std::lock_guard<std::mutex> lock(map_mtx);
+  auto iter = mapped_regions.find((uintptr_t)old_address);
+  if (iter == mapped_regions.end()) return;
+  MappedRegion region = iter->second;
+  size_t region_length = region.end - iter->first;
+  size_t moved = std::min(old_size, region_length);
+  size_t moved_resident =
+      (size_t)((double)region.resident * moved / region_length);
+  mapped_regions.erase(iter);
+  mapped_bytes -= moved;
+  if (moved < region_length) {
+    MappedRegion remainder = region;
+    remainder.offset += moved;
+    remainder.resident = region.resident - moved_resident;
+    mapped_regions.insert_or_assign((uintptr_t)old_address + moved, remainder);
+  }
+  // MREMAP_FIXED unmaps whatever was at the destination
+  map_region_clear((uintptr_t)new_address, (uintptr_t)new_address + new_size);
+  MappedRegion next = region;
+  next.end = (uintptr_t)new_address + new_size;
+  next.resident = moved_resident;
+  mapped_regions.insert_or_assign((uintptr_t)new_address, next);
+  mapped_bytes += new_size;
+  num_mapped_regions.store(mapped_regions.size(), std::memory_order_relaxed);
+}
+
+void brahma::POSIXDFTracer::hint_add(int fd, off64_t offset, off64_t len) {
+  if (fd < 0 || fd >= MAX_FD || offset < 0) return;
+  if (len == 0) {
+    // a zero length hint extends to the end of the file
+    struct stat st;
+    if (df_fstat(fd, &st) != 0 || st.st_size <= offset) return;
+    len = st.st_size - offset;
+  }
+  std::lock_guard<std::mutex> lock(hint_mtx);
+  HintState &state = hints[fd];
+  if (!hinted_fd[fd].load(std::memory_order_relaxed)) {
+    state = HintState();
+    hinted_fd[fd].store(true, std::memory_order_relaxed);
+  }
+  // only bytes that were not hinted already count again
+  size_t overlap = subtract_range(state.ranges, offset, offset + len);
+  state.ranges.emplace_back(offset, offset + len);
+  if (state.ranges.size() > MAX_HINT_RANGES) {
+    state.ranges.erase(state.ranges.begin());
+  }
+  state.hinted_bytes += len - overlap;
+}
+
+void brahma::POSIXDFTracer::hint_drop(int fd, off64_t offset, off64_t len) {
+  if (!is_hinted(fd)) return;
+  std::lock_guard<std::mutex> lock(hint_mtx);
+  auto iter = hints.find(fd);
+  if (iter == hints.end()) return;
+  off64_t end = len == 0 ? std::numeric_limits<off64_t>::max() : offset + len;
+  subtract_range(iter->second.ranges, offset, end);
+}
+
+void brahma::POSIXDFTracer::hint_observe(int fd, off64_t offset, ssize_t ret,
+                                         TimeResolution elapsed) {
+  if (ret <= 0) return;
+  if (offset < 0) {
+    off64_t current = df_lseek(fd, 0, SEEK_CUR);
+    if (current < ret) return;
+    offset = current - ret;
+  }
+  std::lock_guard<std::mutex> lock(hint_mtx);
+  auto iter = hints.find(fd);
+  if (iter == hints.end()) return;
+  HintState &state = iter->second;
+  size_t covered = subtract_range(state.ranges, offset, offset + ret);
+  if (covered > 0) {
+    state.hinted_read_bytes += covered;
+    state.hinted_reads++;
+    state.hinted_read_time += elapsed;
+  } else {
+    state.unhinted_reads++;
+    state.unhinted_read_time += elapsed;
+  }
+}
+
+bool brahma::POSIXDFTracer::hint_release(int fd, HintState &state) {
+  if (fd < 0 || fd >= MAX_FD) return false;
+  std::lock_guard<std::mutex> lock(hint_mtx);
+  hinted_fd[fd].store(false, std::memory_order_relaxed);
+  auto iter = hints.find(fd);
+  if (iter == hints.end()) return false;
+  state = iter->second;
+  hints.erase(iter);
+  return true;
+}
+
+void brahma::POSIXDFTracer::access_summary(int fd, HashType hash) {
+  if (fd < 0 || fd >= MAX_FD) return;
+  AccessPattern state;
+  {
+    std::lock_guard<std::mutex> lock(access_mtx[fd % ACCESS_STRIPES]);
+    state = access_state[fd];
+  }
+  if (state.requests == 0) return;
+  const char *pattern = "single";
+  size_t transitions = state.requests - 1;
+  if (transitions > 0) {
+    if (state.sequential * 10 >= transitions * 8) {
+      pattern = "sequential";
+    } else if ((state.sequential + state.strided) * 10 >= transitions * 8 &&
+               state.strided > state.sequential) {
+      pattern = "strided";
+    } else {
+      pattern = "random";
+    }
+  }
+  dftracer::Metadata *metadata = nullptr;
+  if (logger->include_metadata) {
+    metadata = new dftracer::Metadata();
+    metadata->insert_or_assign("fhash", hash);
+    metadata->insert_or_assign("pattern", pattern);
+    metadata->insert_or_assign("stride", state.stride, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("requests", state.requests,
+                               MetadataType::MT_VALUE);
+    metadata->insert_or_assign("bytes", state.bytes, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("sequential", state.sequential,
+                               MetadataType::MT_VALUE);
+    metadata->insert_or_assign("strided", state.strided,
+                               MetadataType::MT_VALUE);
+    metadata->insert_or_assign("seeks", state.seeks, MetadataType::MT_VALUE);
+    static const char *bin_names[ACCESS_SIZE_BINS] = {
+        "size_lt_4k", "size_lt_16k", "size_lt_64k", "size_lt_256k",
+        "size_lt_1m", "size_lt_4m",  "size_ge_4m"};
+    for (int bin = 0; bin < ACCESS_SIZE_BINS; ++bin) {
+      metadata->insert_or_assign(bin_names[bin], state.size_hist[bin],
+                                 MetadataType::MT_VALUE);
+    }
+  }
+  TimeResolution end_time = logger->get_time();
+  logger->enter_event();
+  logger->log("access_pattern", CATEGORY, state.open_time,
+              end_time - state.open_time, metadata);
+  logger->exit_event();
+}
+
+int brahma::POSIXDFTracer::posix_fadvise(int fd, off_t offset, off_t len,
+                                         int advice) {
+  DFT_MAP_OR_FAIL(posix_fadvise);
+  DFT_LOGGER_START(fd);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(len, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(advice, MetadataType::MT_VALUE);
+  int ret = __real_posix_fadvise(fd, offset, len, advice);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace && ret == 0) {
+    if (advice == POSIX_FADV_WILLNEED) hint_add(fd, offset, len);
+    if (advice == POSIX_FADV_DONTNEED) hint_drop(fd, offset, len);
+  }
+  return ret;
+}
+
+int brahma::POSIXDFTracer::posix_fadvise64(int fd, off64_t offset,
+                                           off64_t len, int advice) {
+  DFT_MAP_OR_FAIL(posix_fadvise64);
+  DFT_LOGGER_START(fd);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(len, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(advice, MetadataType::MT_VALUE);
+  int ret = __real_posix_fadvise64(fd, offset, len, advice);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace && ret == 0) {
+    if (advice == POSIX_FADV_WILLNEED) hint_add(fd, offset, len);
+    if (advice == POSIX_FADV_DONTNEED) hint_drop(fd, offset, len);
+  }
+  return ret;
+}
+
+ssize_t brahma::POSIXDFTracer::readahead(int fd, off64_t offset,
+                                         size_t count) {
+  DFT_MAP_OR_FAIL(readahead);
+  DFT_LOGGER_START(fd);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
+  ssize_t ret = __real_readahead(fd, offset, count);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  if (trace && ret == 0 && count > 0) hint_add(fd, offset, count);
+  return ret;
+}
+
+int brahma::POSIXDFTracer::munmap(void *addr, size_t length) {
+  DFT_MAP_OR_FAIL(munmap);
+  // residency has to be sampled while the range is still mapped
+  MapRelease release = map_region_sample(addr, length);
+  DFT_LOGGER_START_HASH(release.fhash);
+  DFT_LOGGER_UPDATE_TYPE(length, MetadataType::MT_VALUE);
+  if (trace) {
+    size_t unmapped = release.unmapped;
+    size_t resident = release.resident;
+    long resident_delta = release.resident_delta;
+    size_t mapped = release.mapped;
+    DFT_LOGGER_UPDATE_TYPE(unmapped, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(resident, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(resident_delta, MetadataType::MT_VALUE);
+    DFT_LOGGER_UPDATE_TYPE(mapped, MetadataType::MT_VALUE);
+  }
+  int ret = __real_munmap(addr, length);
+  if (ret == 0) map_region_remove(addr, length);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::msync(void *addr, size_t length, int flags) {
+  DFT_MAP_OR_FAIL(msync);
+  off64_t offset = 0;
+  DFT_LOGGER_START_HASH(map_region_find(addr, offset));
+  DFT_LOGGER_UPDATE_TYPE(length, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  int ret = __real_msync(addr, length, flags);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+int brahma::POSIXDFTracer::madvise(void *addr, size_t length, int advice) {
+  DFT_MAP_OR_FAIL(madvise);
+  off64_t offset = 0;
+  DFT_LOGGER_START_HASH(map_region_find(addr, offset));
+  DFT_LOGGER_UPDATE_TYPE(length, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(advice, MetadataType::MT_VALUE);
+  int ret = __real_madvise(addr, length, advice);
+  DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_END();
+  return ret;
+}
+
+void *brahma::POSIXDFTracer::mremap(void *old_address, size_t old_size,
+                                    size_t new_size, int flags,
+                                    void *new_address) {
+  DFT_MAP_OR_FAIL(mremap);
+  off64_t offset = 0;
+  DFT_LOGGER_START_HASH(map_region_find(old_address, offset));
+  DFT_LOGGER_UPDATE_TYPE(old_size, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(new_size, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(offset, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_TYPE(flags, MetadataType::MT_VALUE);
+  void *ret =
+      __real_mremap(old_address, old_size, new_size, flags, new_address);
+  DFT_LOGGER_END();
+  if (ret != MAP_FAILED) {
+    if (trace)
+      map_region_move(old_address, old_size, ret, new_size);
+    else
+      map_region_remove(ret, new_size);
+  }
+  return ret;
+}
+
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, readv,
+                   (int fd, const struct iovec *iov, int iovcnt),
+                   (fd, iov, iovcnt))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, writev,
+                   (int fd, const struct iovec *iov, int iovcnt),
+                   (fd, iov, iovcnt))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, preadv,
+                   (int fd, const struct iovec *iov, int iovcnt, off_t offset),
+                   (fd, iov, iovcnt, offset))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, pwritev,
+                   (int fd, const struct iovec *iov, int iovcnt, off_t offset),
+                   (fd, iov, iovcnt, offset))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, preadv2,
+                   (int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                    int flags),
+                   (fd, iov, iovcnt, offset, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, pwritev2,
+                   (int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                    int flags),
+                   (fd, iov, iovcnt, offset, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, copy_file_range,
+                   (int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
+                    size_t len, unsigned int flags),
+                   (fd_in, off_in, fd_out, off_out, len, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, sendfile,
+                   (int out_fd, int in_fd, off_t *offset, size_t count),
+                   (out_fd, in_fd, offset, count))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, splice,
+                   (int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
+                    size_t len, unsigned int flags),
+                   (fd_in, off_in, fd_out, off_out, len, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, aio_read,
+                   (struct aiocb * aiocbp), (aiocbp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, aio_write,
+                   (struct aiocb * aiocbp), (aiocbp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, lio_listio,
+                   (int mode, struct aiocb *const aiocb_list[], int nitems,
+                    struct sigevent *sevp),
+                   (mode, aiocb_list, nitems, sevp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, aio_suspend,
+                   (const struct aiocb *const aiocb_list[], int nitems,
+                    const struct timespec *timeout),
+                   (aiocb_list, nitems, timeout))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, aio_error,
+                   (const struct aiocb *aiocbp), (aiocbp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, aio_return,
+                   (struct aiocb * aiocbp), (aiocbp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, stat,
+                   (const char *path, struct stat *buf), (path, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, lstat,
+                   (const char *path, struct stat *buf), (path, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, fstat,
+                   (int fd, struct stat *buf), (fd, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, fstatat,
+                   (int dirfd, const char *path, struct stat *buf, int flags),
+                   (dirfd, path, buf, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, stat64,
+                   (const char *path, struct stat64 *buf), (path, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, lstat64,
+                   (const char *path, struct stat64 *buf), (path, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, fstat64,
+                   (int fd, struct stat64 *buf), (fd, buf))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, fstatat64,
+                   (int dirfd, const char *path, struct stat64 *buf,
+                    int flags),
+                   (dirfd, path, buf, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, __fxstatat,
+                   (int vers, int dirfd, const char *path, struct stat *buf,
+                    int flags),
+                   (vers, dirfd, path, buf, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, __fxstatat64,
+                   (int vers, int dirfd, const char *path, struct stat64 *buf,
+                    int flags),
+                   (vers, dirfd, path, buf, flags))
+#ifdef STATX_BASIC_STATS
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, statx,
+                   (int dirfd, const char *path, int flags, unsigned int mask,
+                    struct statx *buf),
+                   (dirfd, path, flags, mask, buf))
+#endif
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, DIR *, fdopendir, (int fd), (fd))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, struct dirent *, readdir,
+                   (DIR * dirp), (dirp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, struct dirent64 *, readdir64,
+                   (DIR * dirp), (dirp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, getdents64,
+                   (int fd, void *dirp, size_t count), (fd, dirp, count))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, closedir, (DIR * dirp), (dirp))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, posix_fadvise,
+                   (int fd, off_t offset, off_t len, int advice),
+                   (fd, offset, len, advice))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, posix_fadvise64,
+                   (int fd, off64_t offset, off64_t len, int advice),
+                   (fd, offset, len, advice))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, ssize_t, readahead,
+                   (int fd, off64_t offset, size_t count), (fd, offset, count))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, munmap,
+                   (void *addr, size_t length), (addr, length))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, msync,
+                   (void *addr, size_t length, int flags),
+                   (addr, length, flags))
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, madvise,
+                   (void *addr, size_t length, int advice),
+                   (addr, length, advice))
+
+DFT_GOTCHA_WRAPPER(brahma::POSIXDFTracer, int, execve,
+                   (const char *pathname, char *const argv[],
+                    char *const envp[]),
+                   (pathname, argv, envp))
+
+// mremap is variadic, the target address is only passed with MREMAP_FIXED
+static void *mremap_dft_wrapper(void *old_address, size_t old_size,
+                                size_t new_size, int flags, ...) {
+  void *new_address = nullptr;
+  if (flags & MREMAP_FIXED) {
+    va_list args;
+    va_start(args, flags);
+    new_address = va_arg(args, void *);
+    va_end(args);
+  }
+  auto instance = brahma::POSIXDFTracer::get_active_instance();
+  if (instance == nullptr) {
+    DFT_MAP_OR_FAIL(mremap);
+    return __real_mremap(old_address, old_size, new_size, flags, new_address);
+  }
+  return instance->mremap(old_address, old_size, new_size, flags,
+                          new_address);
+}
+
+static gotcha_binding_t posix_extended_bindings[] = {
+    DFT_GOTCHA_BINDING(readv),    DFT_GOTCHA_BINDING(writev),
+    DFT_GOTCHA_BINDING(preadv),   DFT_GOTCHA_BINDING(pwritev),
+    DFT_GOTCHA_BINDING(preadv2),  DFT_GOTCHA_BINDING(pwritev2),
+    DFT_GOTCHA_BINDING(copy_file_range),
+    DFT_GOTCHA_BINDING(sendfile), DFT_GOTCHA_BINDING(splice),
+    DFT_GOTCHA_BINDING(aio_read),    DFT_GOTCHA_BINDING(aio_write),
+    DFT_GOTCHA_BINDING(lio_listio),  DFT_GOTCHA_BINDING(aio_suspend),
+    DFT_GOTCHA_BINDING(aio_error),   DFT_GOTCHA_BINDING(aio_return),
+    DFT_GOTCHA_BINDING(stat),        DFT_GOTCHA_BINDING(lstat),
+    DFT_GOTCHA_BINDING(fstat),       DFT_GOTCHA_BINDING(fstatat),
+    DFT_GOTCHA_BINDING(stat64),      DFT_GOTCHA_BINDING(lstat64),
+    DFT_GOTCHA_BINDING(fstat64),     DFT_GOTCHA_BINDING(fstatat64),
+    DFT_GOTCHA_BINDING(__fxstatat),  DFT_GOTCHA_BINDING(__fxstatat64),
+#ifdef STATX_BASIC_STATS
+    DFT_GOTCHA_BINDING(statx),
+#endif
+    DFT_GOTCHA_BINDING(fdopendir),   DFT_GOTCHA_BINDING(readdir),
+    DFT_GOTCHA_BINDING(readdir64),   DFT_GOTCHA_BINDING(getdents64),
+    DFT_GOTCHA_BINDING(closedir),
+    DFT_GOTCHA_BINDING(posix_fadvise),
+    DFT_GOTCHA_BINDING(posix_fadvise64),
+    DFT_GOTCHA_BINDING(readahead),
+    DFT_GOTCHA_BINDING(munmap),      DFT_GOTCHA_BINDING(msync),
+    DFT_GOTCHA_BINDING(madvise),     DFT_GOTCHA_BINDING(mremap),
+    DFT_GOTCHA_BINDING(execve),
+#if __WORDSIZE == 64
+    // the LFS variants are aliases with the same layout on 64-bit targets
+    DFT_GOTCHA_ALIAS_BINDING(aio_read64, aio_read),
+    DFT_GOTCHA_ALIAS_BINDING(aio_write64, aio_write),
+    DFT_GOTCHA_ALIAS_BINDING(lio_listio64, lio_listio),
+    DFT_GOTCHA_ALIAS_BINDING(aio_suspend64, aio_suspend),
+    DFT_GOTCHA_ALIAS_BINDING(aio_error64, aio_error),
+    DFT_GOTCHA_ALIAS_BINDING(aio_return64, aio_return),
+    DFT_GOTCHA_ALIAS_BINDING(preadv64, preadv),
+    DFT_GOTCHA_ALIAS_BINDING(pwritev64, pwritev),
+    DFT_GOTCHA_ALIAS_BINDING(preadv64v2, preadv2),
+    DFT_GOTCHA_ALIAS_BINDING(pwritev64v2, pwritev2),
+    DFT_GOTCHA_ALIAS_BINDING(sendfile64, sendfile),
+#endif
+};
+
+void brahma::POSIXDFTracer::bind_extended(const char *name, int priority) {
+  DFTRACER_LOG_DEBUG("POSIXDFTracer.bind_extended %s", name);
+  gotcha_set_priority(name, priority);
+  auto status = gotcha_wrap(
+      posix_extended_bindings,
+      sizeof(posix_extended_bindings) / sizeof(gotcha_binding_t), name);
+  if (status != GOTCHA_SUCCESS) {
+    DFTRACER_LOG_WARN("POSIXDFTracer.bind_extended returned %d", status);
+  }
+}
@@ -5,18 +5,32 @@
 #ifndef DFTRACER_POSIX_H
 #define DFTRACER_POSIX_H
 
+#include <aio.h>
 #include <brahma/brahma.h>
 #include <dftracer/core/common/constants.h>
 #include <dftracer/core/common/logging.h>
 #include <dftracer/core/common/typedef.h>
+#include <dftracer/core/common/singleton.h>
 #include <dftracer/core/df_logger.h>
+#include <dftracer/core/utils/configuration_manager.h>
 #include <dftracer/core/utils/md5.h>
+#include <dftracer/core/utils/posix_internal.h>
 #include <dftracer/core/utils/utils.h>
+#include <dirent.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -31,6 +45,182 @@ class POSIXDFTracer : public POSIX {
   std::shared_ptr<DFTLogger> logger;
   bool trace_all_files;
 
+  static const size_t MAX_PENDING_AIO = 1 << 16;
+  struct PendingAIO {
+    HashType fhash;
+    ConstEventNameType name;
+    TimeResolution start_time;
+    TimeResolution end_time;
+    size_t count;
+    off64_t offset;
+  };
+  std::mutex aio_mtx;
+  std::unordered_map<const void *, PendingAIO> pending_aio;
+
+  void aio_begin(const void *aiocbp, HashType hash, int opcode, size_t count,
+                 off64_t offset, TimeResolution start_time);
+  HashType aio_pending_hash(const void *aiocbp);
+  void aio_complete(const void *aiocbp);
+  void aio_end(const void *aiocbp, ssize_t ret);
+
+  // readdir calls are folded into one summary per stream emitted at closedir
+  static const size_t MAX_DIR_SCANS = 1 << 14;
+  struct DirScan {
+    HashType fhash;
+    TimeResolution open_time;
+    TimeResolution read_time;
+    size_t calls;
+    size_t entries;
+    size_t bytes;
+  };
+  std::mutex dir_mtx;
+  std::unordered_map<const void *, DirScan> dir_scans;
+  // size of dir_scans, read without the lock by readdir
+  std::atomic<size_t> num_dir_scans;
+
+  void dir_scan_begin(const void *dirp, HashType hash,
+                      TimeResolution open_time);
+  bool dir_scan_tracked(const void *dirp);
+  void dir_scan_add(const void *dirp, size_t bytes, TimeResolution elapsed);
+  bool dir_scan_end(const void *dirp, DirScan &scan);
+
+  // live file mappings keyed by start address; resident holds the bytes of
+  // the region found in page cache when it was mapped
+  static const size_t MAX_MAPPED_REGIONS = 1 << 16;
+  struct MappedRegion {
+    uintptr_t end;
+    HashType fhash;
+    off64_t offset;
+    size_t resident;
+  };
+  std::mutex map_mtx;
+  std::map<uintptr_t, MappedRegion> mapped_regions;
+  size_t mapped_bytes;
+  // lets calls on untracked memory skip map_mtx while nothing is mapped
+  std::atomic<size_t> num_mapped_regions;
+  struct MapRelease {
+    HashType fhash;
+    size_t unmapped;
+    size_t resident;
+    long resident_delta;
+    size_t mapped;
+  };
+
+  void map_region_add(void *addr, size_t length, HashType hash,
+                      off64_t offset);
+  HashType map_region_find(const void *addr, off64_t &offset);
+  // residency of the tracked part of a range, sampled before it is unmapped
+  MapRelease map_region_sample(void *addr, size_t length);
+  void map_region_remove(void *addr, size_t length);
+  // drops the tracked part of [start, end), map_mtx must be held
+  void map_region_clear(uintptr_t start, uintptr_t end);
+  void map_region_move(void *old_address, size_t old_size, void *new_address,
+                       size_t new_size);
+
+  // page cache residency is probed on a few evenly spread windows per file;
+  // page_cache_budget caps the pages probed per file over the whole run
+  static const size_t PAGE_CACHE_WINDOWS = 16;
+  static const size_t PAGE_CACHE_WINDOW_PAGES = 16;
+  bool page_cache_sampling;
+  size_t page_cache_budget;
+  std::mutex page_cache_mtx;
+  std::unordered_map<HashType, size_t> page_cache_probed;
+
+  double sample_page_cache(int fd, HashType hash);
+  static size_t resident_bytes(uintptr_t start, size_t length);
+
+  // WILLNEED/readahead ranges not yet read per fd and how reads on that fd
+  // fared inside and outside of them
+  static const size_t MAX_HINT_RANGES = 64;
+  struct HintState {
+    std::vector<std::pair<off64_t, off64_t>> ranges;
+    size_t hinted_bytes;
+    size_t hinted_read_bytes;
+    size_t hinted_reads;
+    size_t unhinted_reads;
+    TimeResolution hinted_read_time;
+    TimeResolution unhinted_read_time;
+  };
+  // written under hint_mtx, read without it on every read call
+  std::atomic<bool> hinted_fd[MAX_FD];
+  std::mutex hint_mtx;
+  std::unordered_map<int, HintState> hints;
+
+  // fds beyond MAX_FD are not tracked rather than aliased
+  inline bool is_hinted(int fd) const {
+    return fd >= 0 && fd < MAX_FD &&
+           hinted_fd[fd].load(std::memory_order_relaxed);
+  }
+
+  void hint_add(int fd, off64_t offset, off64_t len);
+  void hint_drop(int fd, off64_t offset, off64_t len);
+  void hint_observe(int fd, off64_t offset, ssize_t ret,
+                    TimeResolution elapsed);
+  bool hint_release(int fd, HintState &state);
+
+  // offset and stride tracking per fd, summarised in an access_pattern event
+  // at close. Request sizes are binned by powers of four starting at 4KB.
+  static const int ACCESS_SIZE_BINS = 7;
+  struct AccessPattern {
+    TimeResolution open_time;
+    off64_t offset;
+    off64_t last_offset;
+    off64_t last_end;
+    off64_t stride;
+    size_t requests;
+    size_t sequential;
+    size_t strided;
+    size_t seeks;
+    size_t bytes;
+    size_t size_hist[ACCESS_SIZE_BINS];
+  };
+  bool access_pattern;
+  // a slot is guarded by the stripe fd % ACCESS_STRIPES, as threads may share
+  // an fd; fds beyond MAX_FD get no summary rather than an aliased one
+  static const int ACCESS_STRIPES = 64;
+  AccessPattern access_state[MAX_FD];
+  std::mutex access_mtx[ACCESS_STRIPES];
+
+  // offset < 0 uses and advances the tracked file offset
+  inline void access_request(int fd, off64_t offset, ssize_t size) {
+    if (fd < 0 || fd >= MAX_FD || size <= 0) return;
+    std::lock_guard<std::mutex> lock(access_mtx[fd % ACCESS_STRIPES]);
+    AccessPattern &state = access_state[fd];
+    bool positional = offset >= 0;
+    if (!positional) offset = state.offset;
+    if (state.requests > 0) {
+      off64_t stride = offset - state.last_offset;
+      if (offset == state.last_end) {
+        state.sequential++;
+      } else if (stride == state.stride) {
+        state.strided++;
+      }
+      state.stride = stride;
+    }
+    state.last_offset = offset;
+    state.last_end = offset + size;
+    if (!positional) state.offset = state.last_end;
+    state.requests++;
+    state.bytes += size;
+    int bin = 0;
+    size_t limit = 4096;
+    while (bin < ACCESS_SIZE_BINS - 1 && (size_t)size >= limit) {
+      limit <<= 2;
+      bin++;
+    }
+    state.size_hist[bin]++;
+  }
+
+  inline void access_seek(int fd, off64_t offset) {
+    if (fd < 0 || fd >= MAX_FD || offset < 0) return;
+    std::lock_guard<std::mutex> lock(access_mtx[fd % ACCESS_STRIPES]);
+    AccessPattern &state = access_state[fd];
+    if (offset != state.offset) state.seeks++;
+    state.offset = offset;
+  }
+
+  void access_summary(int fd, HashType hash);
+
   inline HashType is_traced(int fd, const char *func) {
     if (fd < 0) return NO_HASH_DEFAULT;
     HashType trace = tracked_fd[fd % MAX_FD];
@@ -59,10 +249,30 @@ class POSIXDFTracer : public POSIX {
     }
   }
 
+  // resolves *at() style arguments so that the hash matches the one open()
+  // records for the same path
+  inline HashType is_traced_at(int dirfd, const char *path, int flags,
+                               const char *func) {
+    if (path == nullptr) return NO_HASH_DEFAULT;
+    if (path[0] == '\0') {
+      if (flags & AT_EMPTY_PATH) return is_traced(dirfd, func);
+      return NO_HASH_DEFAULT;
+    }
+    if (path[0] == '/' || dirfd == AT_FDCWD) return is_traced(path, func);
+    if (stop_trace) return NO_HASH_DEFAULT;
+    std::string filename = get_filename(dirfd) + "/" + path;
+    return is_traced(filename.c_str(), func);
+  }
+
   inline void trace(int fd, HashType hash) {
     DFTRACER_LOG_DEBUG("Calling POSIXDFTracer.trace for %d and %d", fd, hash);
     if (fd == -1) return;
     tracked_fd[fd % MAX_FD] = hash;
+    if (access_pattern && fd < MAX_FD) {
+      std::lock_guard<std::mutex> lock(access_mtx[fd % ACCESS_STRIPES]);
+      access_state[fd] = AccessPattern();
+      access_state[fd].open_time = logger->get_time();
+    }
   }
 
   inline void remove_trace(int fd) {
@@ -72,9 +282,34 @@ class POSIXDFTracer : public POSIX {
   }
 
  public:
-  POSIXDFTracer(bool trace_all) : POSIX(), trace_all_files(trace_all) {
+  POSIXDFTracer(bool trace_all)
+      : POSIX(),
+        trace_all_files(trace_all),
+        aio_mtx(),
+        pending_aio(),
+        dir_mtx(),
+        dir_scans(),
+        num_dir_scans(0),
+        map_mtx(),
+        mapped_regions(),
+        mapped_bytes(0),
+        num_mapped_regions(0),
+        page_cache_sampling(false),
+        page_cache_budget(0),
+        page_cache_mtx(),
+        page_cache_probed(),
+        hint_mtx(),
+        hints(),
+        access_pattern(false) {
     DFTRACER_LOG_DEBUG("POSIX class intercepted", "");
+    auto conf =
+        dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+    page_cache_sampling = conf->page_cache_sampling;
+    page_cache_budget = conf->page_cache_budget;
+    access_pattern = conf->access_pattern;
     for (int i = 0; i < MAX_FD; ++i) tracked_fd[i] = NO_HASH_DEFAULT;
+    for (int i = 0; i < MAX_FD; ++i)
+      hinted_fd[i].store(false, std::memory_order_relaxed);
     logger = DFT_LOGGER_INIT();
   }
   void finalize() {
@@ -94,6 +329,15 @@ class POSIXDFTracer : public POSIX {
     }
     return instance;
   }
+  static std::shared_ptr<POSIXDFTracer> get_active_instance() {
+    if (stop_trace) return nullptr;
+    return instance;
+  }
+  inline HashType get_fd_hash(int fd) { return is_traced(fd, __FUNCTION__); }
+  /**
+   * Binds the calls that brahma's POSIX interface does not expose.
+   */
+  void bind_extended(const char *name, int priority);
 
   int open(const char *pathname, int flags, ...) override;
 
@@ -210,11 +454,101 @@ class POSIXDFTracer : public POSIX {
   int execvpe(const char *file, char *const argv[],
               char *const envp[]) override;
 
+  int execve(const char *pathname, char *const argv[], char *const envp[]);
+
   int fork() override;
 
   void exit(int status) override;
 
   void _exit(int status) override;
+
+  ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
+
+  ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
+
+  ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+  ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+  ssize_t preadv2(int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                  int flags);
+
+  ssize_t pwritev2(int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                   int flags);
+
+  ssize_t copy_file_range(int fd_in, off64_t *off_in, int fd_out,
+                          off64_t *off_out, size_t len, unsigned int flags);
+
+  ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
+  ssize_t splice(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
+                 size_t len, unsigned int flags);
+
+  int aio_read(struct aiocb *aiocbp);
+
+  int aio_write(struct aiocb *aiocbp);
+
+  int lio_listio(int mode, struct aiocb *const aiocb_list[], int nitems,
+                 struct sigevent *sevp);
+
+  int aio_suspend(const struct aiocb *const aiocb_list[], int nitems,
+                  const struct timespec *timeout);
+
+  int aio_error(const struct aiocb *aiocbp);
+
+  ssize_t aio_return(struct aiocb *aiocbp);
+
+  int stat(const char *path, struct stat *buf);
+
+  int lstat(const char *path, struct stat *buf);
+
+  int fstat(int fd, struct stat *buf);
+
+  int fstatat(int dirfd, const char *path, struct stat *buf, int flags);
+
+  int stat64(const char *path, struct stat64 *buf);
+
+  int lstat64(const char *path, struct stat64 *buf);
+
+  int fstat64(int fd, struct stat64 *buf);
+
+  int fstatat64(int dirfd, const char *path, struct stat64 *buf, int flags);
+
+  int __fxstatat(int vers, int dirfd, const char *path, struct stat *buf,
+                 int flags);
+
+  int __fxstatat64(int vers, int dirfd, const char *path, struct stat64 *buf,
+                   int flags);
+
+#ifdef STATX_BASIC_STATS
+  int statx(int dirfd, const char *path, int flags, unsigned int mask,
+            struct statx *buf);
+#endif
+
+  DIR *fdopendir(int fd);
+
+  struct dirent *readdir(DIR *dirp);
+
+  struct dirent64 *readdir64(DIR *dirp);
+
+  ssize_t getdents64(int fd, void *dirp, size_t count);
+
+  int closedir(DIR *dirp);
+
+  int posix_fadvise(int fd, off_t offset, off_t len, int advice);
+
+  int posix_fadvise64(int fd, off64_t offset, off64_t len, int advice);
+
+  ssize_t readahead(int fd, off64_t offset, size_t count);
+
+  int munmap(void *addr, size_t length);
+
+  int msync(void *addr, size_t length, int flags);
+
+  int madvise(void *addr, size_t length, int advice);
+
+  void *mremap(void *old_address, size_t old_size, size_t new_size, int flags,
+               void *new_address);
 };
 
 }  // namespace brahma
@@ -48,6 +48,7 @@ size_t brahma::STDIODFTracer::fread(void *ptr, size_t size, size_t count,
   DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
   size_t ret = __real_fread(ptr, size, count, fp);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_BYTES(ret * size);
   DFT_LOGGER_END();
   return ret;
 }
@@ -62,6 +63,7 @@ size_t brahma::STDIODFTracer::fwrite(const void *ptr, size_t size, size_t count,
   DFT_LOGGER_UPDATE_TYPE(count, MetadataType::MT_VALUE);
   size_t ret = __real_fwrite(ptr, size, count, fp);
   DFT_LOGGER_UPDATE_TYPE(ret, MetadataType::MT_VALUE);
+  DFT_LOGGER_UPDATE_BYTES(ret * size);
   DFT_LOGGER_END();
   return ret;
 }
@@ -1,31 +1,241 @@
 #include <dftracer/core/buffer/buffer.h>
+
+#include <algorithm>
 template <>
 std::shared_ptr<dftracer::BufferManager>
     dftracer::Singleton<dftracer::BufferManager>::instance = nullptr;
 template <>
 bool dftracer::Singleton<dftracer::BufferManager>::stop_creating_instances =
     false;
+std::atomic<const char*> dftracer::BufferManager::flight_dump_reason(nullptr);
+
+void dft_flight_recorder_request(const char* reason) {
+  dftracer::BufferManager::request_flight_dump(reason);
+}
+
 namespace dftracer {
 
 void BufferManager::compress_and_write_if_needed(size_t size, bool force) {
-  if (force || buffer_pos + size > this->config->write_buffer_size) {
-    if (this->config->compression) {
+  if (force || buffer_pos + size > flush_size) {
+    if (mmap_buffer != nullptr) {
+      write_mmap_buffer(buffer_pos + size);
+      buffer_pos = 0;
+      return;
+    }
+    if (compression) {
       size = this->compressor->compress(buffer, buffer_pos + size);
     } else {
       size = buffer_pos + size;
     }
     if (size > 0) {
-      size = this->writer->write(buffer, size, true);
+      if (flight_recorder) {
+        record_chunk(size);
+      } else {
+        if (this->writer->needs_rotation()) rotate_segment();
+        size = this->writer->write(buffer, size, true);
+      }
     }
     buffer_pos = 0;
   } else {
     buffer_pos += size;
+    if (mmap_buffer != nullptr) mmap_buffer->commit(buffer_pos);
   }
 }
+
+// the mapped events are released only once they reached the trace file, a
+// kill in between leaves them for dftracer_recover
+void BufferManager::write_mmap_buffer(size_t size) {
+  const char* data = buffer;
+  if (compression) {
+    size = this->compressor->compress(buffer, size, mmap_scratch.data());
+    data = mmap_scratch.data();
+  }
+  if (size > 0) {
+    if (this->writer->needs_rotation()) rotate_segment();
+    this->writer->write(data, size, true);
+  }
+  mmap_buffer->written(this->writer->size());
+}
+
+// writes data as separate chunks of at most write_buffer_size, leaving the
+// buffer untouched
+void BufferManager::write_direct(const char* data, size_t size) {
+  if (!compression) {
+    this->writer->write(data, size, true);
+    return;
+  }
+  std::vector<char> out(this->compressor->chunk_size());
+  while (size > 0) {
+    size_t piece = std::min(size, this->config->write_buffer_size);
+    size_t compressed = this->compressor->compress(data, piece, out.data());
+    if (compressed > 0) this->writer->write(out.data(), compressed, true);
+    data += piece;
+    size -= piece;
+  }
+}
+
+// ends the current segment with the footer and starts the next one with the
+// header and all metadata so far, so each segment can be read on its own
+void BufferManager::rotate_segment() {
+  char footer[8];
+  size_t size = this->serializer->finalize(footer, true);
+  write_direct(footer, size);
+  this->writer->rotate();
+  start_segment();
+  DFTRACER_LOG_INFO("BufferManager.rotate_segment %s",
+                    this->writer->get_filename());
+}
+
+void BufferManager::start_segment() {
+  char header[8];
+  size_t size = this->serializer->initialize(header, hostname_hash);
+  std::string preamble(header, size);
+  preamble += segment_metadata;
+  write_direct(preamble.data(), preamble.size());
+  if (mmap_buffer != nullptr) {
+    mmap_buffer->retarget(this->writer->get_filename(), this->writer->size());
+  }
+}
+
+std::string BufferManager::handoff(std::vector<uint64_t>& blocks,
+                                   std::string& target) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  DFTRACER_LOG_DEBUG("BufferManager.handoff", "");
+  if (buffer == nullptr || flight_recorder || !this->writer->mpi_shared()) {
+    return std::string();
+  }
+  compress_and_write_if_needed(0, true);
+  char footer[8];
+  size_t size = this->serializer->finalize(footer, true);
+  write_direct(footer, size);
+  std::string staged = this->writer->handoff(blocks);
+  target = this->writer->handoff_target();
+  start_segment();
+  handed_off = true;
+  tail_events = 0;
+  DFTRACER_LOG_INFO("BufferManager.handoff %s continues in %s",
+                    staged.c_str(), this->writer->get_filename());
+  return staged;
+}
+
+void BufferManager::release_handoff(const std::string& staged, bool written) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  this->writer->release(staged, written);
+}
+
+void BufferManager::record_chunk(size_t size) {
+  flight_ring.emplace_back(buffer, size);
+  flight_ring_bytes += size;
+  while (flight_ring_bytes > this->config->flight_recorder_size &&
+         flight_ring.size() > 1) {
+    flight_ring_bytes -= flight_ring.front().size();
+    flight_ring.pop_front();
+    flight_evicted++;
+  }
+}
+
+void BufferManager::dump_flight_recorder_locked(const char* reason,
+                                                ProcessID process_id,
+                                                ThreadID tid) {
+  char value[256];
+  snprintf(value, sizeof(value), "reason=%s,chunks=%zu,bytes=%zu,evicted=%zu",
+           reason, flight_ring.size() + 1, flight_ring_bytes + buffer_pos,
+           flight_evicted);
+  size_t size = this->serializer->metadata(buffer + buffer_pos,
+                                           "flight_recorder", value,
+                                           CUSTOM_METADATA, process_id, tid);
+  compress_and_write_if_needed(size, true);
+  if (!flight_dumped) {
+    this->writer->write(flight_header.data(), flight_header.size(), true);
+  }
+  for (const auto& chunk : flight_ring) {
+    this->writer->write(chunk.data(), chunk.size(), true);
+  }
+  this->writer->flush();
+  DFTRACER_LOG_INFO("BufferManager.dump_flight_recorder %s", value);
+  flight_ring.clear();
+  flight_ring_bytes = 0;
+  flight_evicted = 0;
+  flight_dumped = true;
+}
+
+void BufferManager::prepare_fork() {
+  mtx.lock();
+  fork_locked = true;
+  if (buffer == nullptr) return;
+  // the flight recorder ring stays with the parent
+  if (buffer_pos > 0 && !flight_recorder) {
+    compress_and_write_if_needed(0, true);
+  }
+  this->writer->flush();
+}
+
+void BufferManager::parent_after_fork() {
+  if (!fork_locked) return;
+  fork_locked = false;
+  mtx.unlock();
+}
+
+void BufferManager::child_after_fork() {
+  if (!fork_locked) return;
+  fork_locked = false;
+  if (buffer != nullptr) {
+    if (mmap_buffer != nullptr) {
+      mmap_buffer->detach();
+      mmap_buffer.reset();
+      mmap_scratch.clear();
+    } else {
+      free(buffer);
+    }
+    buffer = nullptr;
+    buffer_pos = 0;
+    this->writer->forked();
+    if (this->aggregator != nullptr) this->aggregator->forked();
+  }
+  flight_ring.clear();
+  flight_ring_bytes = 0;
+  flight_evicted = 0;
+  // the lock is owned by the parent's forking thread, whose tid the child
+  // does not have, so unlock would leave it write locked
+  new (&mtx) std::shared_mutex();
+}
+
+void BufferManager::dump_flight_recorder(const char* reason,
+                                         ProcessID process_id, ThreadID tid) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  DFTRACER_LOG_DEBUG("BufferManager.dump_flight_recorder %s", reason);
+  if (!flight_recorder || buffer == nullptr) return;
+  dump_flight_recorder_locked(reason, process_id, tid);
+}
 int BufferManager::initialize(const char* filename, HashType hostname_hash) {
   DFTRACER_LOG_DEBUG("BufferManager.initialize %s %d", filename, hostname_hash);
   this->config =
       dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  this->hostname_hash = hostname_hash;
+  segment_metadata.clear();
+  handed_off = false;
+  tail_events = 0;
+  this->writer = dftracer::Singleton<dftracer::STDIOWriter>::get_instance();
+  this->writer->initialize(filename);
+  // dftracer_service compresses what it receives
+  compression = this->config->compression && !this->writer->shared();
+  if (buffer == nullptr && this->config->mmap_buffer) {
+    if (this->writer->shared()) {
+      DFTRACER_LOG_WARN("BufferManager.initialize mmap buffer is not used "
+                        "with dftracer_service", "");
+    } else if (this->config->flight_recorder) {
+      DFTRACER_LOG_WARN("BufferManager.initialize mmap buffer is not used "
+                        "with the flight recorder", "");
+    } else {
+      // next to the file actually written, which may be a staged segment
+      mmap_buffer = std::make_shared<dftracer::MmapBuffer>();
+      buffer = mmap_buffer->initialize(
+          this->writer->get_filename(),
+          this->config->write_buffer_size + 16 * 1024,
+          compression);
+      if (buffer == nullptr) mmap_buffer.reset();
+    }
+  }
   if (buffer == nullptr) {
     buffer = (char*)malloc(this->config->write_buffer_size + 16 * 1024);
   }
@@ -34,38 +244,98 @@ int BufferManager::initialize(const char* filename, HashType hostname_hash) {
     DFTRACER_LOG_ERROR("BufferManager.BufferManager Failed to allocate buffer",
                        "");
   }
-  this->writer = dftracer::Singleton<dftracer::STDIOWriter>::get_instance();
-  this->writer->initialize(filename);
   this->serializer = dftracer::Singleton<dftracer::JsonLines>::get_instance();
   this->aggregator = dftracer::Singleton<dftracer::Aggregator>::get_instance();
-  if (this->config->compression) {
+  if (compression) {
     this->compressor =
         dftracer::Singleton<dftracer::ZlibCompression>::get_instance();
     this->compressor->initialize(this->config->write_buffer_size);
+    if (mmap_buffer != nullptr) {
+      mmap_scratch.resize(this->compressor->chunk_size());
+    }
   }
+  if (mmap_buffer != nullptr) mmap_buffer->written(this->writer->size());
+  aggregation_enable = this->config->aggregation_enable;
+  aggregation_used = aggregation_enable;
+  flush_size = this->config->write_buffer_size;
+  // the flight recorder never writes before a trigger
+  flush_interval = this->config->flush_interval_ms * 1000;
+  if (this->config->flight_recorder) flush_interval = 0;
+  next_flush_time = 0;
+  flight_recorder = this->config->flight_recorder;
+  flight_ring.clear();
+  flight_ring_bytes = 0;
+  flight_evicted = 0;
+  flight_dumped = false;
   size_t size = this->serializer->initialize(buffer, hostname_hash);
-  compress_and_write_if_needed(size);
+  if (flight_recorder) {
+    // smaller chunks so that eviction keeps most of the ring populated
+    size_t chunk = std::max<size_t>(this->config->flight_recorder_size / 8, 1);
+    flush_size = std::min(flush_size, chunk);
+    if (compression) {
+      size = this->compressor->compress(buffer, size);
+    }
+    flight_header.assign(buffer, size);
+  } else {
+    compress_and_write_if_needed(size);
+  }
   return 0;
 }
 
+void BufferManager::set_aggregation(bool enable, int index,
+                                    ProcessID process_id) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  DFTRACER_LOG_DEBUG("BufferManager.set_aggregation %d", enable);
+  if (enable == aggregation_enable || buffer == nullptr) return;
+  aggregation_enable = enable;
+  if (enable) {
+    aggregation_used = true;
+    return;
+  }
+  auto data = dftracer::AggregatedDataType();
+  this->aggregator->get_previous_aggregations(data, true);
+  size_t size = this->serializer->aggregated(buffer + buffer_pos, index,
+                                             process_id, data);
+  compress_and_write_if_needed(size);
+}
+
 int BufferManager::finalize(int index, ProcessID process_id, bool end_sym) {
   std::unique_lock<std::shared_mutex> lock(mtx);
   if (buffer) {
     size_t size = 0;
-    if (this->config->aggregation_enable) {
+    if (aggregation_used) {
       auto data = dftracer::AggregatedDataType();
       this->aggregator->get_previous_aggregations(data, true);
       size = this->serializer->aggregated(buffer + buffer_pos, index,
                                           process_id, data);
       this->aggregator->finalize();
     }
-    auto end_size =
-        this->serializer->finalize(buffer + buffer_pos + size, end_sym);
-    compress_and_write_if_needed(size + end_size, true);
+    if (flight_recorder) {
+      // events since the last dump are only kept if a dump was requested
+      buffer_pos += size;
+      size = 0;
+      dump_if_requested(process_id, 0);
+      if (flight_dumped) {
+        buffer_pos = 0;
+        flight_recorder = false;
+      }
+    }
+    if (!flight_recorder) {
+      auto end_size =
+          this->serializer->finalize(buffer + buffer_pos + size, end_sym);
+      compress_and_write_if_needed(size + end_size, true);
+    }
 
-    if (this->config->compression) this->compressor->finalize();
-    this->writer->finalize(index);
-    free(buffer);
+    if (compression) this->compressor->finalize();
+    // after a handoff only events logged since are worth keeping
+    this->writer->finalize(handed_off && tail_events == 0 ? 0 : index);
+    if (mmap_buffer != nullptr) {
+      mmap_buffer->finalize();
+      mmap_buffer.reset();
+      mmap_scratch.clear();
+    } else {
+      free(buffer);
+    }
     buffer = nullptr;
     buffer_pos = 0;
   }
@@ -82,7 +352,7 @@ void BufferManager::log_data_event(int index, ConstEventNameType event_name,
   DFTRACER_LOG_DEBUG("BufferManager.log_data_event %d", index);
   size_t size = 0;
   bool enable_tracing = true;
-  if (this->config->aggregation_enable && strcmp(category, "dftracer") != 0) {
+  if (aggregation_enable && strcmp(category, "dftracer") != 0) {
     enable_tracing = false;
     auto aggregated_key =
         AggregatedKey{category, event_name, start_time,     duration,
@@ -106,7 +376,19 @@ void BufferManager::log_data_event(int index, ConstEventNameType event_name,
         this->serializer->data(buffer + buffer_pos, index, event_name, category,
                                start_time, duration, metadata, process_id, tid);
   }
-  compress_and_write_if_needed(size);
+  if (handed_off) tail_events++;
+  bool due = flush_due(start_time + duration);
+  compress_and_write_if_needed(size, due);
+  if (due) this->writer->flush();
+  if (flight_recorder) {
+    if (this->config->flight_recorder_trigger_us > 0 &&
+        duration >= this->config->flight_recorder_trigger_us &&
+        strcmp(category, "dftracer") != 0) {
+      dump_flight_recorder_locked("latency", process_id, tid);
+    } else {
+      dump_if_requested(process_id, tid);
+    }
+  }
 }
 
 void BufferManager::log_counter_event(int index, ConstEventNameType name,
@@ -119,7 +401,27 @@ void BufferManager::log_counter_event(int index, ConstEventNameType name,
   size_t size =
       this->serializer->counter(buffer + buffer_pos, index, name, category,
                                 start_time, process_id, thread_id, metadata);
-  compress_and_write_if_needed(size);
+  if (handed_off) tail_events++;
+  bool due = flush_due(start_time);
+  compress_and_write_if_needed(size, due);
+  if (due) this->writer->flush();
+}
+
+void BufferManager::log_lines(const char* lines, size_t size) {
+  std::unique_lock<std::shared_mutex> lock(mtx);
+  DFTRACER_LOG_DEBUG("BufferManager.log_lines %d", size);
+  if (buffer == nullptr) return;
+  while (size > 0) {
+    size_t piece = std::min(size, flush_size - buffer_pos);
+    if (piece == 0) {
+      compress_and_write_if_needed(0, true);
+      continue;
+    }
+    memcpy(buffer + buffer_pos, lines, piece);
+    compress_and_write_if_needed(piece);
+    lines += piece;
+    size -= piece;
+  }
 }
 
 void BufferManager::log_metadata_event(ConstEventNameType name,
@@ -131,6 +433,9 @@ void BufferManager::log_metadata_event(ConstEventNameType name,
   DFTRACER_LOG_DEBUG("BufferManager.log_metadata_event %s", value);
   size_t size = this->serializer->metadata(buffer + buffer_pos, name, value, ph,
                                            process_id, tid, is_string);
+  if (this->writer->rotating() || this->writer->mpi_shared()) {
+    segment_metadata.append(buffer + buffer_pos, size);
+  }
   compress_and_write_if_needed(size);
 }
 }  // namespace dftracer
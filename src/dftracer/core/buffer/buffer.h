@@ -4,6 +4,7 @@
 #include <dftracer/core/compression/zlib_compression.h>
 //
 #include <dftracer/core/aggregator/aggregator.h>
+#include <dftracer/core/buffer/mmap_buffer.h>
 #include <dftracer/core/common/cpp_typedefs.h>
 #include <dftracer/core/common/datastructure.h>
 #include <dftracer/core/common/enumeration.h>
@@ -13,14 +14,39 @@
 #include <dftracer/core/writer/stdio_writer.h>
 
 #include <any>
+#include <atomic>
+#include <deque>
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 namespace dftracer {
 class BufferManager {
  public:
   BufferManager()
-      : buffer(nullptr), buffer_pos(0), mtx(), app_name(), rank(-1) {}
+      : buffer(nullptr),
+        buffer_pos(0),
+        mtx(),
+        app_name(),
+        rank(-1),
+        aggregation_enable(false),
+        aggregation_used(false),
+        compression(false),
+        hostname_hash(nullptr),
+        segment_metadata(),
+        handed_off(false),
+        tail_events(0),
+        fork_locked(false),
+        flush_size(0),
+        flush_interval(0),
+        next_flush_time(0),
+        flight_recorder(false),
+        flight_header(),
+        flight_ring(),
+        flight_ring_bytes(0),
+        flight_evicted(0),
+        flight_dumped(false),
+        mmap_scratch() {}
   ~BufferManager() {}
 
   void inline set_app_name(const char* name) { app_name = name; }
@@ -30,9 +56,14 @@ class BufferManager {
   }
 
   void inline set_rank(const int& r) { rank = r; }
+  int inline get_rank() const { return rank; }
 
   int initialize(const char* filename, HashType hostname_hash);
 
+  // switches aggregation at runtime, pending aggregations are written out
+  // when it is turned off
+  void set_aggregation(bool enable, int index, ProcessID process_id);
+
   int finalize(int index, ProcessID process_id, bool end_sym = false);
 
   void log_data_event(int index, ConstEventNameType event_name,
@@ -49,13 +80,90 @@ class BufferManager {
                          ProcessID process_id, ThreadID thread_id,
                          dftracer::Metadata* metadata);
 
+  // appends complete serialized event lines, used by dftracer_service for
+  // the events it receives from traced processes
+  void log_lines(const char* lines, size_t size);
+
+  // ends the trace written so far for the shared MPI file and returns the
+  // staged file, its chunk sizes and the log file it stands for, empty if
+  // there is nothing to share. Later events continue in a new segment.
+  std::string handoff(std::vector<uint64_t>& blocks, std::string& target);
+  // written tells whether the staged file made it into the shared file
+  void release_handoff(const std::string& staged, bool written);
+
+  // pthread_atfork handlers. prepare writes out the buffer and holds the
+  // lock across fork so the child neither inherits events it would write
+  // again nor a lock taken by a thread it does not have. The child drops
+  // the parent's buffer, file and pending state; initialize then starts
+  // its own trace.
+  void prepare_fork();
+  void parent_after_fork();
+  void child_after_fork();
+
+  // writes the flight recorder ring to the trace file
+  void dump_flight_recorder(const char* reason, ProcessID process_id,
+                            ThreadID tid);
+
+  // marks the flight recorder for dumping by the next data event or by
+  // finalize. Only stores a pointer so it is safe within signal handlers.
+  static inline void request_flight_dump(const char* reason) {
+    flight_dump_reason.store(reason);
+  }
+
  private:
   void compress_and_write_if_needed(size_t size, bool force = false);
+  // the event time serves as the clock so the check is one comparison; an
+  // idle process is therefore not flushed until its next event
+  inline bool flush_due(TimeResolution time) {
+    if (flush_interval == 0 || time < next_flush_time) return false;
+    bool due = next_flush_time != 0;
+    next_flush_time = time + flush_interval;
+    return due;
+  }
+  void write_mmap_buffer(size_t size);
+  void write_direct(const char* data, size_t size);
+  void rotate_segment();
+  void start_segment();
+  void record_chunk(size_t size);
+  void dump_flight_recorder_locked(const char* reason, ProcessID process_id,
+                                   ThreadID tid);
+  inline void dump_if_requested(ProcessID process_id, ThreadID tid) {
+    if (flight_dump_reason.load(std::memory_order_relaxed) == nullptr) return;
+    const char* reason = flight_dump_reason.exchange(nullptr);
+    if (reason != nullptr) dump_flight_recorder_locked(reason, process_id, tid);
+  }
   char* buffer;
   size_t buffer_pos;
   std::shared_mutex mtx;
   std::string app_name;
   int rank;
+  bool aggregation_enable;
+  bool aggregation_used;
+  // config->compression unless the events go to dftracer_service
+  bool compression;
+  HashType hostname_hash;
+  // every metadata line written, repeated at the start of each new segment
+  std::string segment_metadata;
+  // events logged after the trace was handed to the shared MPI file
+  bool handed_off;
+  size_t tail_events;
+  bool fork_locked;
+  size_t flush_size;
+  TimeResolution flush_interval;
+  TimeResolution next_flush_time;
+  // flight recorder: serialized (and compressed) chunks of the most recent
+  // events, the oldest chunks are evicted once the ring exceeds its size
+  bool flight_recorder;
+  std::string flight_header;
+  std::deque<std::string> flight_ring;
+  size_t flight_ring_bytes;
+  size_t flight_evicted;
+  bool flight_dumped;
+  static std::atomic<const char*> flight_dump_reason;
+  // crash survivable backing store of buffer, compressed output goes to
+  // mmap_scratch so the mapped events stay intact until they are written
+  std::shared_ptr<dftracer::MmapBuffer> mmap_buffer;
+  std::vector<char> mmap_scratch;
 
   std::shared_ptr<dftracer::ConfigurationManager> config;
   std::shared_ptr<dftracer::JsonLines> serializer;
@@ -0,0 +1,78 @@
+#include <dftracer/core/buffer/mmap_buffer.h>
+#include <dftracer/core/utils/posix_internal.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace dftracer {
+char *MmapBuffer::initialize(const char *trace_file, size_t capacity,
+                             bool compression) {
+  DFTRACER_LOG_DEBUG("MmapBuffer.initialize %s %d", trace_file, capacity);
+  if (strlen(trace_file) >= sizeof(header->trace_file)) {
+    DFTRACER_LOG_ERROR("MmapBuffer.initialize path too long %s", trace_file);
+    return nullptr;
+  }
+  path = std::string(trace_file) + DFT_MMAP_BUFFER_SUFFIX;
+  fd = df_open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    DFTRACER_LOG_ERROR("MmapBuffer.initialize unable to create %s: %s",
+                       path.c_str(), strerror(errno));
+    return nullptr;
+  }
+  length = MMAP_BUFFER_HEADER_SIZE + capacity;
+  void *region = MAP_FAILED;
+  if (df_ftruncate(fd, length) == 0) {
+    region =
+        df_mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (region == MAP_FAILED) {
+    DFTRACER_LOG_ERROR("MmapBuffer.initialize unable to map %s: %s",
+                       path.c_str(), strerror(errno));
+    df_close(fd);
+    df_unlink(path.c_str());
+    fd = -1;
+    length = 0;
+    return nullptr;
+  }
+  header = static_cast<MmapBufferHeader *>(region);
+  memset(header, 0, MMAP_BUFFER_HEADER_SIZE);
+  header->version = DFT_MMAP_BUFFER_VERSION;
+  header->compression = compression ? 1 : 0;
+  header->capacity = capacity;
+  strcpy(header->trace_file, trace_file);
+  // magic last so that a partially written header is never recovered
+  memcpy(header->magic, DFT_MMAP_BUFFER_MAGIC, sizeof(DFT_MMAP_BUFFER_MAGIC));
+  DFTRACER_LOG_INFO("created mmap buffer %s", path.c_str());
+  return reinterpret_cast<char *>(header) + MMAP_BUFFER_HEADER_SIZE;
+}
+
+void MmapBuffer::retarget(const char *trace_file, size_t trace_size) {
+  if (header == nullptr ||
+      strlen(trace_file) >= sizeof(header->trace_file)) {
+    return;
+  }
+  strcpy(header->trace_file, trace_file);
+  header->trace_size = trace_size;
+}
+
+void MmapBuffer::finalize() {
+  if (header == nullptr) return;
+  DFTRACER_LOG_DEBUG("MmapBuffer.finalize %s", path.c_str());
+  df_munmap(header, length);
+  df_close(fd);
+  df_unlink(path.c_str());
+  header = nullptr;
+  fd = -1;
+  length = 0;
+}
+
+void MmapBuffer::detach() {
+  if (header == nullptr) return;
+  df_munmap(header, length);
+  df_close(fd);
+  header = nullptr;
+  fd = -1;
+  length = 0;
+}
+}  // namespace dftracer
@@ -0,0 +1,77 @@
+#ifndef DFTRACER_MMAP_BUFFER_H
+#define DFTRACER_MMAP_BUFFER_H
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/typedef.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dftracer {
+#define DFT_MMAP_BUFFER_MAGIC "DFTMMAP"
+#define DFT_MMAP_BUFFER_VERSION 1
+#define DFT_MMAP_BUFFER_SUFFIX ".mmap"
+
+/**
+ * Header of a crash survivable buffer file. The events serialized after the
+ * header have not been written to trace_file yet; everything before
+ * trace_size in trace_file is complete.
+ */
+struct MmapBufferHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t compression;
+  uint64_t capacity;
+  // bytes of complete events after the header
+  uint64_t committed;
+  // size of trace_file when the buffer was last written out
+  uint64_t trace_size;
+  char trace_file[4056];
+};
+static const size_t MMAP_BUFFER_HEADER_SIZE = sizeof(MmapBufferHeader);
+static_assert(MMAP_BUFFER_HEADER_SIZE == 4096,
+              "mmap buffer header must fill one page");
+
+/**
+ * Backing store for the BufferManager buffer in a preallocated memory mapped
+ * file next to the trace file. Events are serialized straight into the
+ * mapping and the committed length in the header is advanced after each
+ * event, so the page cache holds them even if the process is killed. The
+ * dftracer_recover tool finishes trace files from such buffers.
+ */
+class MmapBuffer {
+ private:
+  int fd;
+  size_t length;
+  MmapBufferHeader *header;
+  std::string path;
+
+ public:
+  MmapBuffer() : fd(-1), length(0), header(nullptr), path() {}
+  ~MmapBuffer() { finalize(); }
+
+  // returns the start of the event region or nullptr if the file could not
+  // be mapped
+  char *initialize(const char *trace_file, size_t capacity, bool compression);
+
+  inline void commit(size_t committed) {
+    __atomic_store_n(&header->committed, committed, __ATOMIC_RELEASE);
+  }
+
+  // the region was written to the trace file which is now trace_size long
+  inline void written(size_t trace_size) {
+    header->trace_size = trace_size;
+    commit(0);
+  }
+
+  // the trace moved on to a new segment file that is trace_size long
+  void retarget(const char *trace_file, size_t trace_size);
+
+  // unmaps and removes the buffer file after a clean finalize
+  void finalize();
+
+  // in a forked child: unmaps the parent's buffer, its file is left alone
+  void detach();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_MMAP_BUFFER_H
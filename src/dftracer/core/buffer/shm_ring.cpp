@@ -0,0 +1,204 @@
+#include <dftracer/core/buffer/shm_ring.h>
+#include <dftracer/core/utils/posix_internal.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+namespace dftracer {
+// how long a full ring may see no progress before it is abandoned
+static const auto SHM_RING_TIMEOUT = std::chrono::seconds(5);
+static const auto SHM_RING_POLL = std::chrono::microseconds(50);
+
+static std::string service_name() {
+  return "/" DFT_SHM_SERVICE_PREFIX + std::to_string(getuid());
+}
+
+static bool alive(ProcessID pid) {
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+ProcessID ShmRing::service_pid() {
+  int service_fd = shm_open(service_name().c_str(), O_RDONLY, 0);
+  if (service_fd == -1) return 0;
+  int32_t pid = 0;
+  if (df_read(service_fd, &pid, sizeof(pid)) != sizeof(pid)) pid = 0;
+  df_close(service_fd);
+  return alive(pid) ? pid : 0;
+}
+
+bool ShmRing::publish_service() {
+  int service_fd =
+      shm_open(service_name().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (service_fd == -1) return false;
+  int32_t pid = df_getpid();
+  bool ok = df_write(service_fd, &pid, sizeof(pid)) == sizeof(pid);
+  df_close(service_fd);
+  return ok;
+}
+
+void ShmRing::withdraw_service() { shm_unlink(service_name().c_str()); }
+
+bool ShmRing::map() {
+  void *region =
+      df_mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (region == MAP_FAILED) return false;
+  header = static_cast<ShmRingHeader *>(region);
+  data = static_cast<char *>(region) + SHM_RING_HEADER_SIZE;
+  return true;
+}
+
+bool ShmRing::create(size_t capacity) {
+  static std::atomic<unsigned> sequence(0);
+  ProcessID pid = df_getpid();
+  // a sequence number as a process may reinitialize before its old ring
+  // has been drained
+  name = DFT_SHM_RING_PREFIX + std::to_string(getuid()) + "." +
+         std::to_string(pid) + "." + std::to_string(sequence++);
+  DFTRACER_LOG_DEBUG("ShmRing.create %s %d", name.c_str(), capacity);
+  service = service_pid();
+  if (service == 0) return false;
+  size_t page = sysconf(_SC_PAGESIZE);
+  capacity = std::max(page, (capacity + page - 1) / page * page);
+  fd = shm_open(("/" + name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1) {
+    DFTRACER_LOG_ERROR("ShmRing.create unable to create %s: %s",
+                       name.c_str(), strerror(errno));
+    return false;
+  }
+  length = SHM_RING_HEADER_SIZE + capacity;
+  if (df_ftruncate(fd, length) != 0 || !map()) {
+    DFTRACER_LOG_ERROR("ShmRing.create unable to map %s: %s", name.c_str(),
+                       strerror(errno));
+    df_close(fd);
+    shm_unlink(("/" + name).c_str());
+    fd = -1;
+    return false;
+  }
+  memset(header, 0, SHM_RING_HEADER_SIZE);
+  header->version = DFT_SHM_RING_VERSION;
+  header->pid = pid;
+  header->capacity = capacity;
+  // magic last so that the service never drains a partial header
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(header->magic, DFT_SHM_RING_MAGIC, sizeof(DFT_SHM_RING_MAGIC));
+  DFTRACER_LOG_INFO("created shared memory ring %s", name.c_str());
+  return true;
+}
+
+size_t ShmRing::write(const char *buffer, size_t len) {
+  if (header == nullptr) return 0;
+  if (__atomic_load_n(&header->closed, __ATOMIC_RELAXED)) {
+    header->dropped += len;
+    return 0;
+  }
+  uint64_t capacity = header->capacity;
+  uint64_t head = header->head;
+  size_t done = 0;
+  size_t polls = 0;
+  auto stalled = std::chrono::steady_clock::now();
+  while (done < len) {
+    uint64_t tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+    size_t space = capacity - (head - tail);
+    if (space == 0) {
+      bool timeout =
+          std::chrono::steady_clock::now() - stalled > SHM_RING_TIMEOUT;
+      if (timeout || (++polls % 256 == 0 && !alive(service))) {
+        DFTRACER_LOG_ERROR("ShmRing.write service stopped draining %s",
+                           name.c_str());
+        header->dropped += len - done;
+        __atomic_store_n(&header->closed, 1, __ATOMIC_RELEASE);
+        break;
+      }
+      std::this_thread::sleep_for(SHM_RING_POLL);
+      continue;
+    }
+    stalled = std::chrono::steady_clock::now();
+    size_t n = std::min(space, len - done);
+    size_t pos = head % capacity;
+    size_t first = std::min<size_t>(n, capacity - pos);
+    memcpy(data + pos, buffer + done, first);
+    memcpy(data, buffer + done + first, n - first);
+    head += n;
+    done += n;
+    __atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+  }
+  return done;
+}
+
+void ShmRing::close() {
+  if (header == nullptr) return;
+  DFTRACER_LOG_DEBUG("ShmRing.close %s", name.c_str());
+  if (header->dropped > 0) {
+    DFTRACER_LOG_WARN("ShmRing.close %s dropped %lu bytes", name.c_str(),
+                      header->dropped);
+  }
+  __atomic_store_n(&header->closed, 1, __ATOMIC_RELEASE);
+  detach();
+}
+
+bool ShmRing::attach(const std::string &ring_name) {
+  name = ring_name;
+  fd = shm_open(("/" + name).c_str(), O_RDWR, 0);
+  if (fd == -1) return false;
+  struct stat st;
+  if (df_fstat(fd, &st) != 0 || (size_t)st.st_size <= SHM_RING_HEADER_SIZE) {
+    detach();
+    return false;
+  }
+  length = st.st_size;
+  if (!map()) {
+    header = nullptr;
+    detach();
+    return false;
+  }
+  if (memcmp(header->magic, DFT_SHM_RING_MAGIC, sizeof(DFT_SHM_RING_MAGIC)) !=
+          0 ||
+      header->version != DFT_SHM_RING_VERSION ||
+      header->capacity != length - SHM_RING_HEADER_SIZE) {
+    detach();
+    return false;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return true;
+}
+
+size_t ShmRing::read(std::string &out) {
+  uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+  uint64_t tail = header->tail;
+  size_t n = head - tail;
+  if (n == 0) return 0;
+  uint64_t capacity = header->capacity;
+  size_t pos = tail % capacity;
+  size_t first = std::min<size_t>(n, capacity - pos);
+  out.append(data + pos, first);
+  out.append(data, n - first);
+  __atomic_store_n(&header->tail, head, __ATOMIC_RELEASE);
+  return n;
+}
+
+bool ShmRing::finished() {
+  bool closed = __atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) != 0;
+  if (!closed && alive(header->pid)) return false;
+  return __atomic_load_n(&header->head, __ATOMIC_ACQUIRE) == header->tail;
+}
+
+void ShmRing::release() {
+  detach();
+  if (!name.empty()) shm_unlink(("/" + name).c_str());
+}
+
+void ShmRing::detach() {
+  if (header != nullptr) df_munmap(header, length);
+  if (fd != -1) df_close(fd);
+  header = nullptr;
+  data = nullptr;
+  fd = -1;
+  length = 0;
+}
+}  // namespace dftracer
@@ -0,0 +1,93 @@
+#ifndef DFTRACER_SHM_RING_H
+#define DFTRACER_SHM_RING_H
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/typedef.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dftracer {
+#define DFT_SHM_RING_MAGIC "DFTRING"
+#define DFT_SHM_RING_VERSION 1
+// shm_open names, uid and pid are appended
+#define DFT_SHM_RING_PREFIX "dftracer-ring."
+#define DFT_SHM_SERVICE_PREFIX "dftracer-service."
+#define DFT_SHM_DIR "/dev/shm/"
+
+/**
+ * Header of a per-process event ring. The process appends the trace as a
+ * byte stream and advances head, dftracer_service copies it out and
+ * advances tail. Both counters only grow; the data offset is the counter
+ * modulo capacity. head and tail live on separate cache lines.
+ */
+struct ShmRingHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t pid;
+  uint64_t capacity;
+  // bytes lost because the service did not keep up
+  uint64_t dropped;
+  uint32_t closed;
+  char pad0[28];
+  uint64_t head;
+  char pad1[56];
+  uint64_t tail;
+  char pad2[3960];
+};
+static const size_t SHM_RING_HEADER_SIZE = sizeof(ShmRingHeader);
+static_assert(SHM_RING_HEADER_SIZE == 4096, "ring header must fill one page");
+
+/**
+ * Single producer single consumer ring in shared memory between a traced
+ * process and dftracer_service. The producer side is used by the SHM writer
+ * backend under the BufferManager lock; the consumer side by the service.
+ * Neither side takes a lock, the counters are published with release
+ * stores and read with acquire loads.
+ */
+class ShmRing {
+ private:
+  int fd;
+  size_t length;
+  ShmRingHeader *header;
+  char *data;
+  std::string name;
+  ProcessID service;
+
+  bool map();
+
+ public:
+  ShmRing()
+      : fd(-1), length(0), header(nullptr), data(nullptr), name(), service(0) {}
+  ~ShmRing() { detach(); }
+
+  // pid of the running dftracer_service of this user or 0 if none
+  static ProcessID service_pid();
+  // announces this process as the service, withdraw removes it again
+  static bool publish_service();
+  static void withdraw_service();
+
+  // producer: creates the ring for this process
+  bool create(size_t capacity);
+  // producer: appends len bytes and waits while the ring is full. If the
+  // service dies or stops draining the ring is closed and everything after
+  // is counted as dropped, so the stream never has a gap in the middle.
+  size_t write(const char *buffer, size_t len);
+  // producer: marks the stream complete and unmaps, the service unlinks it
+  void close();
+
+  // consumer: maps the ring named name (without the /dev/shm prefix)
+  bool attach(const std::string &ring_name);
+  // consumer: appends everything published so far to out
+  size_t read(std::string &out);
+  // consumer: the producer closed the ring or died and it is drained
+  bool finished();
+  // consumer: unmaps and removes the ring
+  void release();
+
+  inline ProcessID pid() const { return header ? header->pid : 0; }
+  inline uint64_t dropped() const { return header ? header->dropped : 0; }
+  void detach();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_SHM_RING_H
@@ -0,0 +1,84 @@
+#include <dftracer/core/coalescer/event_coalescer.h>
+
+template <>
+std::shared_ptr<dftracer::EventCoalescer>
+    dftracer::Singleton<dftracer::EventCoalescer>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::EventCoalescer>::stop_creating_instances =
+    false;
+
+namespace dftracer {
+EventCoalescer::Slot *EventCoalescer::local_slot() {
+  thread_local Slot *slot = nullptr;
+  if (slot == nullptr) {
+    auto created = std::make_shared<Slot>();
+    created->pending = false;
+    std::lock_guard<std::mutex> lock(slots_mtx);
+    slots.push_back(created);
+    slot = created.get();
+  }
+  return slot;
+}
+
+bool EventCoalescer::add(const CoalescedEvent &event,
+                         CoalescedEvent &flushed) {
+  Slot *slot = local_slot();
+  std::lock_guard<std::mutex> lock(slot->mtx);
+  if (slot->pending) {
+    CoalescedEvent &run = slot->run;
+    int64_t offset = event.next_offset < 0
+                         ? -1
+                         : event.next_offset - (int64_t)event.bytes;
+    if (run.fd == event.fd && run.fhash == event.fhash &&
+        run.name == event.name && run.next_offset == offset &&
+        event.start_time >= run.end_time &&
+        event.start_time - run.end_time <= max_gap) {
+      run.ops++;
+      run.bytes += event.bytes;
+      run.end_time = event.end_time;
+      run.next_offset = event.next_offset;
+      if (event.metadata != nullptr) delete event.metadata;
+      return false;
+    }
+    flushed = run;
+    run = event;
+    return true;
+  }
+  slot->run = event;
+  slot->pending = true;
+  return false;
+}
+
+bool EventCoalescer::flush_local(CoalescedEvent &flushed) {
+  Slot *slot = local_slot();
+  std::lock_guard<std::mutex> lock(slot->mtx);
+  if (!slot->pending) return false;
+  flushed = slot->run;
+  slot->pending = false;
+  return true;
+}
+
+void EventCoalescer::forked() {
+  new (&slots_mtx) std::mutex();
+  for (auto &slot : slots) {
+    new (&slot->mtx) std::mutex();
+    if (slot->pending && slot->run.metadata != nullptr) {
+      delete slot->run.metadata;
+    }
+    slot->pending = false;
+  }
+}
+
+std::vector<CoalescedEvent> EventCoalescer::collect() {
+  DFTRACER_LOG_DEBUG("EventCoalescer.collect", "");
+  std::vector<CoalescedEvent> runs;
+  std::lock_guard<std::mutex> slots_lock(slots_mtx);
+  for (auto &slot : slots) {
+    std::lock_guard<std::mutex> lock(slot->mtx);
+    if (!slot->pending) continue;
+    runs.push_back(slot->run);
+    slot->pending = false;
+  }
+  return runs;
+}
+}  // namespace dftracer
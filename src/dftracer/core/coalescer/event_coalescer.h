@@ -0,0 +1,71 @@
+#ifndef DFTRACER_EVENT_COALESCER_H
+#define DFTRACER_EVENT_COALESCER_H
+#include <dftracer/core/common/datastructure.h>
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/common/typedef.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dftracer {
+struct CoalescedEvent {
+  int index;
+  ThreadID tid;
+  ConstEventNameType name;
+  ConstEventNameType category;
+  TimeResolution start_time;
+  TimeResolution end_time;
+  dftracer::Metadata *metadata;
+  HashType fhash;
+  int fd;
+  // offset expected from the next op of the run, -1 for calls using the
+  // file position
+  int64_t next_offset;
+  uint64_t bytes;
+  uint64_t ops;
+};
+
+/**
+ * Merges runs of back to back reads or writes issued by one thread on the
+ * same fd with contiguous offsets. Every thread holds at most one open run;
+ * it is closed by any other event of the thread, by a gap longer than
+ * max_gap between two ops, or at finalize. The first event of a run keeps
+ * its metadata, the others only extend it.
+ */
+class EventCoalescer {
+ private:
+  struct Slot {
+    std::mutex mtx;
+    bool pending;
+    CoalescedEvent run;
+  };
+  std::mutex slots_mtx;
+  std::vector<std::shared_ptr<Slot>> slots;
+  TimeResolution max_gap;
+
+  Slot *local_slot();
+
+ public:
+  EventCoalescer() : slots_mtx(), slots(), max_gap(1000) {
+    DFTRACER_LOG_DEBUG("EventCoalescer.EventCoalescer", "");
+  }
+
+  void set_max_gap(TimeResolution gap) { max_gap = gap; }
+
+  // takes ownership of event; returns true with the run it closed in flushed
+  bool add(const CoalescedEvent &event, CoalescedEvent &flushed);
+
+  // closes the open run of the calling thread
+  bool flush_local(CoalescedEvent &flushed);
+
+  // closes the open runs of all threads
+  std::vector<CoalescedEvent> collect();
+
+  // in a forked child: drops the parent's open runs, see FileCounters
+  void forked();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_EVENT_COALESCER_H
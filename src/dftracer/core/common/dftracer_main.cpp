@@ -4,6 +4,7 @@
 #include <dftracer/core/common/dftracer_main.h>
 #include <dftracer/core/finstrument/functions.h>
 #include <dftracer/core/function/hip/intercept.h>
+#include <dftracer/core/function/io_uring/intercept.h>
 
 template <>
 std::shared_ptr<dftracer::DFTracerCore>
@@ -31,7 +32,10 @@ dftracer::DFTracerCore::DFTracerCore(ProfilerStage stage, ProfileType type,
                                      const int *process_id)
     : is_initialized(false),
       bind(false),
+      fork_prepared(false),
       log_file_suffix(),
+      exec_name(),
+      exec_cmd(),
       include_metadata(false) {
   conf = dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
   DFTRACER_LOG_INFO(
@@ -103,6 +107,18 @@ void dftracer::DFTracerCore::log_metadata(ConstEventNameType key,
     }
   }
 }
+void dftracer::DFTracerCore::dump_flight_recorder(const char *reason) {
+  DFTRACER_LOG_DEBUG("DFTracerCore::dump_flight_recorder", "");
+  if (this->is_initialized && conf->enable) {
+    if (logger != nullptr) {
+      logger->dump_flight_recorder(reason);
+    } else {
+      DFTRACER_LOG_ERROR(
+          "DFTracerCore::dump_flight_recorder logger not initialized", "");
+    }
+  }
+}
+
 bool dftracer::DFTracerCore::finalize() {
   DFTRACER_LOG_DEBUG("DFTracerCore::finalize", "");
   if (this->is_initialized && conf->enable) {
@@ -129,6 +145,13 @@ bool dftracer::DFTracerCore::finalize() {
 #endif
       if (conf->io) {
         DFTRACER_LOG_INFO("Release I/O bindings", "");
+#ifdef DFTRACER_IO_URING_TRACING_ENABLE
+        auto io_uring_instance =
+            dftracer::Singleton<dftracer::IOUringFunction>::get_instance();
+        if (io_uring_instance != nullptr) {
+          io_uring_instance->finalize();
+        }
+#endif
         auto posix_instance = brahma::POSIXDFTracer::get_instance();
         if (posix_instance != nullptr) {
           posix_instance->unbind();
@@ -180,15 +203,97 @@ void dftracer::DFTracerCore::reinitialize() {
   DFTRACER_LOG_INFO(
       "Reinitializing DFTracer with log_file %s data_dirs %s and process %d",
       new_log_file.c_str(), this->data_dirs.c_str(), this->process_id);
-  logger = dftracer::Singleton<DFTLogger>::get_new_instance();
   initialize(false, nullptr, this->data_dirs.c_str(), nullptr);
 }
 
+void dftracer::DFTracerCore::prepare_fork() {
+  if (!this->is_initialized || !conf->enable || logger == nullptr) return;
+  logger->prepare_fork();
+  fork_prepared = true;
+}
+
+void dftracer::DFTracerCore::parent_after_fork() {
+  if (!fork_prepared) return;
+  fork_prepared = false;
+  logger->parent_after_fork();
+}
+
+// the logger is reset in place as the I/O tracers hold on to it
+void dftracer::DFTracerCore::child_after_fork() {
+  if (!fork_prepared) return;
+  fork_prepared = false;
+  logger->child_after_fork();
+  reinitialize();
+}
+
+static void dft_prepare_fork() {
+  auto dftracer = DFTRACER_MAIN_SINGLETON(ProfilerStage::PROFILER_OTHER,
+                                          ProfileType::PROFILER_ANY);
+  if (dftracer != nullptr) dftracer->prepare_fork();
+}
+
+static void dft_parent_after_fork() {
+  auto dftracer = DFTRACER_MAIN_SINGLETON(ProfilerStage::PROFILER_OTHER,
+                                          ProfileType::PROFILER_ANY);
+  if (dftracer != nullptr) dftracer->parent_after_fork();
+}
+
+static void dft_child_after_fork() {
+  auto dftracer = DFTRACER_MAIN_SINGLETON(ProfilerStage::PROFILER_OTHER,
+                                          ProfileType::PROFILER_ANY);
+  if (dftracer != nullptr) dftracer->child_after_fork();
+}
+
+// process name and command line for the trace name and metadata
+void dftracer::DFTracerCore::read_cmdline() {
+  char exec_name[128] = "DEFAULT";
+  char exec_cmd[DFT_PATH_MAX] = "DEFAULT";
+  char cmd[128];
+  sprintf(cmd, "/proc/%d/cmdline", df_getpid());
+  int fd = df_open(cmd, O_RDONLY);
+  if (fd != -1) {
+    ssize_t read_bytes = df_read(fd, exec_cmd, DFT_PATH_MAX);
+    df_close(fd);
+    ssize_t index = 0;
+    size_t last_index = 0;
+    bool has_extracted = false;
+    while (index < read_bytes - 1 && index < DFT_PATH_MAX - 2) {
+      if (exec_cmd[index] == '\0') {
+        if (!has_extracted) {
+          strcpy(exec_name, basename(exec_cmd + last_index));
+          if (exec_name[0] != '-' && strstr(exec_name, "python") == NULL &&
+              strstr(exec_name, "env") == NULL &&
+              strstr(exec_name, "multiprocessing") == NULL) {
+            has_extracted = true;
+            DFTRACER_LOG_INFO("Extracted process_name %s", exec_name);
+          }
+        }
+        exec_cmd[index] = SEPARATOR;
+        last_index = index + 1;
+      }
+      index++;
+    }
+    if (!has_extracted) {
+      if (strstr(exec_name, "multiprocessing") != NULL) {
+        sprintf(exec_name, "DEFAULT-spawn");
+      } else {
+        sprintf(exec_name, "DEFAULT");
+      }
+    }
+    exec_cmd[DFT_PATH_MAX - 1] = '\0';
+    DFTRACER_LOG_DEBUG("Exec command line %s", exec_cmd);
+  }
+  DFTRACER_LOG_INFO("Extracted process_name %s", exec_name);
+  this->exec_name = exec_name;
+  this->exec_cmd = exec_cmd;
+}
+
 void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
                                         const char *_data_dirs,
                                         const int *_process_id) {
   DFTRACER_LOG_DEBUG("DFTracerCore::initialize", "");
   if (conf->bind_signals) set_signal();
+  if (conf->flight_recorder) set_flight_recorder_signal();
   if (!is_initialized) {
     this->bind = _bind;
     include_metadata = conf->metadata;
@@ -201,44 +306,8 @@ void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
         this->process_id = *_process_id;
       }
       DFTRACER_LOG_DEBUG("Setting process_id to %d", this->process_id);
-      char exec_name[128] = "DEFAULT";
-      char exec_cmd[DFT_PATH_MAX] = "DEFAULT";
-      char cmd[128];
-      sprintf(cmd, "/proc/%d/cmdline", df_getpid());
-      int fd = df_open(cmd, O_RDONLY);
-      if (fd != -1) {
-        ssize_t read_bytes = df_read(fd, exec_cmd, DFT_PATH_MAX);
-        df_close(fd);
-        ssize_t index = 0;
-        size_t last_index = 0;
-        bool has_extracted = false;
-        while (index < read_bytes - 1 && index < DFT_PATH_MAX - 2) {
-          if (exec_cmd[index] == '\0') {
-            if (!has_extracted) {
-              strcpy(exec_name, basename(exec_cmd + last_index));
-              if (exec_name[0] != '-' && strstr(exec_name, "python") == NULL &&
-                  strstr(exec_name, "env") == NULL &&
-                  strstr(exec_name, "multiprocessing") == NULL) {
-                has_extracted = true;
-                DFTRACER_LOG_INFO("Extracted process_name %s", exec_name);
-              }
-            }
-            exec_cmd[index] = SEPARATOR;
-            last_index = index + 1;
-          }
-          index++;
-        }
-        if (!has_extracted) {
-          if (strstr(exec_name, "multiprocessing") != NULL) {
-            sprintf(exec_name, "DEFAULT-spawn");
-          } else {
-            sprintf(exec_name, "DEFAULT");
-          }
-        }
-        exec_cmd[DFT_PATH_MAX - 1] = '\0';
-        DFTRACER_LOG_DEBUG("Exec command line %s", exec_cmd);
-      }
-      DFTRACER_LOG_INFO("Extracted process_name %s", exec_name);
+      // a forked child runs the command line of its parent
+      if (exec_name.empty()) read_cmdline();
       if (_log_file == nullptr) {
         if (!conf->log_file.empty()) {
           char log_filename_str[DFT_PATH_MAX];
@@ -246,7 +315,7 @@ void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
           gethostname(hostname, sizeof(hostname));
           hostname[sizeof(hostname) - 1] = '\0';
           snprintf(log_filename_str, sizeof(log_filename_str), "%s-%s-%d",
-                   exec_name, hostname, this->process_id);
+                   exec_name.c_str(), hostname, this->process_id);
           char *log_file_hash = logger->get_hash(log_filename_str);
           DFTRACER_LOG_DEBUG("Conf has log file %s", conf->log_file.c_str());
           std::string extension = ".pfw";
@@ -322,6 +391,7 @@ void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
                 brahma::POSIXDFTracer::get_instance(conf->trace_all_files);
             posix->bind<brahma::POSIXDFTracer>("dftracer",
                                                conf->gotcha_priority);
+            posix->bind_extended("dftracer", conf->gotcha_priority);
           }
           if (conf->stdio) {
             auto stdio =
@@ -329,6 +399,13 @@ void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
             stdio->bind<brahma::STDIODFTracer>("dftracer",
                                                conf->gotcha_priority);
           }
+#ifdef DFTRACER_IO_URING_TRACING_ENABLE
+          if (conf->posix) {
+            auto io_uring_instance =
+                dftracer::Singleton<dftracer::IOUringFunction>::get_instance();
+            io_uring_instance->initialize();
+          }
+#endif
         }
         DFTRACER_LOG_DEBUG("Checking if FTRACING and HIP_TRACING are enabled",
                            "");
@@ -357,6 +434,12 @@ void dftracer::DFTracerCore::initialize(bool _bind, const char *_log_file,
 #endif
     }
     is_initialized = true;
+    // handlers are inherited by children, so one registration per tree
+    static bool fork_handlers = false;
+    if (conf->enable && !fork_handlers) {
+      fork_handlers = pthread_atfork(dft_prepare_fork, dft_parent_after_fork,
+                                     dft_child_after_fork) == 0;
+    }
   }
 }
 
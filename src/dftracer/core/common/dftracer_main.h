@@ -35,8 +35,14 @@ class DFTracerCore {
   ProcessID process_id;
   bool is_initialized;
   bool bind;
+  // prepare_fork flushed and locked the trace
+  bool fork_prepared;
   std::string log_file_suffix;
+  // read once per image, forked children keep them
+  std::string exec_name;
+  std::string exec_cmd;
   std::shared_ptr<DFTLogger> logger;
+  void read_cmdline();
   void initialize(bool _bind, const char *_log_file = nullptr,
                   const char *_data_dirs = nullptr,
                   const int *_process_id = nullptr);
@@ -48,6 +54,11 @@ class DFTracerCore {
                const int *process_id = nullptr);
 
   void reinitialize();
+
+  // pthread_atfork handlers, registered once the tracer is initialized
+  void prepare_fork();
+  void parent_after_fork();
+  void child_after_fork();
   inline bool is_active() {
     DFTRACER_LOG_DEBUG("DFTracerCore.is_active", "");
     return conf->enable;
@@ -61,6 +72,8 @@ class DFTracerCore {
 
   void log_metadata(ConstEventNameType key, ConstEventNameType value);
 
+  void dump_flight_recorder(const char *reason);
+
   inline int enter_event() { return logger->enter_event(); }
 
   inline void exit_event() { logger->exit_event(); }
@@ -6,6 +6,14 @@
 #define DFTRACER_ENUMERATION_H
 #include <cpp-logger/logger.h>
 enum WriterType : uint8_t { CHROME = 0 };
+enum WriterBackendType : uint8_t {
+  WRITER_BACKEND_STDIO = 0,
+  WRITER_BACKEND_PWRITE = 1,
+  WRITER_BACKEND_DIRECT = 2,
+  WRITER_BACKEND_IO_URING = 3,
+  WRITER_BACKEND_MMAP = 4,
+  WRITER_BACKEND_SHM = 5
+};
 enum ProfilerStage : uint8_t {
   PROFILER_INIT = 0,
   PROFILER_FINI = 1,
@@ -29,6 +37,17 @@ enum AggregationType : uint8_t {
   AGGREGATION_TYPE_FULL = 0,
   AGGREGATION_TYPE_SELECTIVE = 1
 };
+enum SamplingType : uint8_t {
+  SAMPLING_TYPE_NONE = 0,
+  SAMPLING_TYPE_COUNT = 1,
+  SAMPLING_TYPE_TIME = 2,
+  SAMPLING_TYPE_RESERVOIR = 3
+};
+enum GovernorLevel : uint8_t {
+  GOVERNOR_LEVEL_FULL = 0,
+  GOVERNOR_LEVEL_AGGREGATED = 1,
+  GOVERNOR_LEVEL_COUNTERS = 2
+};
 enum class RuleOp { AND, OR, NOT, EQ, NEQ, GT, LT, GTE, LTE, IN, LIKE };
 
 inline MetadataType convert(const int &s) {
@@ -94,6 +113,60 @@ inline std::string to_string(const AggregationType &type) {
       return "FULL";
   }
 }
+inline void convert(const std::string &s, SamplingType &type) {
+  if (s == "COUNT") {
+    type = SamplingType::SAMPLING_TYPE_COUNT;
+  } else if (s == "TIME") {
+    type = SamplingType::SAMPLING_TYPE_TIME;
+  } else if (s == "RESERVOIR") {
+    type = SamplingType::SAMPLING_TYPE_RESERVOIR;
+  } else {
+    type = SamplingType::SAMPLING_TYPE_NONE;
+  }
+}
+inline void convert(const std::string &s, WriterBackendType &type) {
+  if (s == "PWRITE") {
+    type = WriterBackendType::WRITER_BACKEND_PWRITE;
+  } else if (s == "DIRECT") {
+    type = WriterBackendType::WRITER_BACKEND_DIRECT;
+  } else if (s == "IO_URING") {
+    type = WriterBackendType::WRITER_BACKEND_IO_URING;
+  } else if (s == "MMAP") {
+    type = WriterBackendType::WRITER_BACKEND_MMAP;
+  } else if (s == "SHM") {
+    type = WriterBackendType::WRITER_BACKEND_SHM;
+  } else {
+    type = WriterBackendType::WRITER_BACKEND_STDIO;
+  }
+}
+inline std::string to_string(const WriterBackendType &type) {
+  switch (type) {
+    case WriterBackendType::WRITER_BACKEND_PWRITE:
+      return "PWRITE";
+    case WriterBackendType::WRITER_BACKEND_DIRECT:
+      return "DIRECT";
+    case WriterBackendType::WRITER_BACKEND_IO_URING:
+      return "IO_URING";
+    case WriterBackendType::WRITER_BACKEND_MMAP:
+      return "MMAP";
+    case WriterBackendType::WRITER_BACKEND_SHM:
+      return "SHM";
+    default:
+      return "STDIO";
+  }
+}
+inline std::string to_string(const GovernorLevel &level) {
+  switch (level) {
+    case GovernorLevel::GOVERNOR_LEVEL_FULL:
+      return "FULL";
+    case GovernorLevel::GOVERNOR_LEVEL_AGGREGATED:
+      return "AGGREGATED";
+    case GovernorLevel::GOVERNOR_LEVEL_COUNTERS:
+      return "COUNTERS";
+    default:
+      return "FULL";
+  }
+}
 
 #define METADATA_NAME_PROCESS "PR"
 #define METADATA_NAME_PROCESS_NAME "process_name"
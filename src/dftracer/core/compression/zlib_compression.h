@@ -37,24 +37,33 @@ class ZlibCompression {
   // Returns the number of bytes written to buffer (compressed size).
   size_t compress(char* buffer, size_t data_size) {
     std::vector<char> out_buffer(chunk_size_);
+    size_t compressed_size = compress(buffer, data_size, out_buffer.data());
+    std::memcpy(buffer, out_buffer.data(), compressed_size);
+    return compressed_size;
+  }
+
+  // Compresses data_size bytes of input into out, which must hold
+  // chunk_size() bytes. Returns the compressed size.
+  size_t compress(const char* input, size_t data_size, char* out) {
     strm_.avail_in = static_cast<uInt>(data_size);
-    strm_.next_in = reinterpret_cast<Bytef*>(buffer);
+    strm_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
     strm_.avail_out = static_cast<uInt>(chunk_size_);
-    strm_.next_out = reinterpret_cast<Bytef*>(out_buffer.data());
+    strm_.next_out = reinterpret_cast<Bytef*>(out);
 
     int ret = deflate(&strm_, Z_FINISH);
     if (ret != Z_STREAM_END && ret != Z_OK) {
       DFTRACER_LOG_ERROR("Compression failed", "");
+      deflateReset(&strm_);
       return 0;
     }
 
     size_t compressed_size = chunk_size_ - strm_.avail_out;
-    std::memcpy(buffer, out_buffer.data(), compressed_size);
-
     deflateReset(&strm_);
     return compressed_size;
   }
 
+  size_t chunk_size() const { return chunk_size_; }
+
   int finalize() {
     deflateEnd(&strm_);
     return 0;
@@ -0,0 +1,69 @@
+#include <dftracer/core/counters/file_counters.h>
+
+template <>
+std::shared_ptr<dftracer::FileCounters>
+    dftracer::Singleton<dftracer::FileCounters>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::FileCounters>::stop_creating_instances =
+    false;
+
+namespace dftracer {
+const char *FileCounters::size_bin_names[FILE_COUNTER_SIZE_BINS] = {
+    "size_0_100",   "size_100_1k",   "size_1k_10k", "size_10k_100k",
+    "size_100k_1m", "size_1m_4m",    "size_4m_10m", "size_10m_100m",
+    "size_100m_1g", "size_1g_plus"};
+
+FileCounters::Shard *FileCounters::local_shard() {
+  thread_local Shard *shard = nullptr;
+  if (shard == nullptr) {
+    auto created = std::make_shared<Shard>();
+    std::lock_guard<std::mutex> lock(shards_mtx);
+    shards.push_back(created);
+    shard = created.get();
+  }
+  return shard;
+}
+
+void FileCounters::forked() {
+  new (&shards_mtx) std::mutex();
+  for (auto &shard : shards) {
+    new (&shard->mtx) std::mutex();
+    shard->records.clear();
+  }
+}
+
+FileCounterMap FileCounters::collect() {
+  DFTRACER_LOG_DEBUG("FileCounters.collect", "");
+  FileCounterMap merged;
+  // shards stay registered as other threads may still hold them
+  std::lock_guard<std::mutex> shards_lock(shards_mtx);
+  for (auto &shard : shards) {
+    FileCounterMap records;
+    {
+      std::lock_guard<std::mutex> lock(shard->mtx);
+      records.swap(shard->records);
+    }
+    for (auto &entry : records) {
+      auto iter = merged.find(entry.first);
+      if (iter == merged.end()) {
+        merged.insert_or_assign(entry.first, entry.second);
+        continue;
+      }
+      FileCounterRecord &into = iter->second;
+      const FileCounterRecord &from = entry.second;
+      into.count += from.count;
+      into.bytes += from.bytes;
+      into.total_time += from.total_time;
+      if (from.max_time > into.max_time) into.max_time = from.max_time;
+      if (from.first_start < into.first_start) {
+        into.first_start = from.first_start;
+      }
+      if (from.last_end > into.last_end) into.last_end = from.last_end;
+      for (int bin = 0; bin < FILE_COUNTER_SIZE_BINS; ++bin) {
+        into.size_hist[bin] += from.size_hist[bin];
+      }
+    }
+  }
+  return merged;
+}
+}  // namespace dftracer
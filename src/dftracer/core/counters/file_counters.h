@@ -0,0 +1,116 @@
+#ifndef DFTRACER_FILE_COUNTERS_H
+#define DFTRACER_FILE_COUNTERS_H
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/common/typedef.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dftracer {
+// request size bins follow darshan: 100, 1K, 10K, 100K, 1M, 4M, 10M, 100M,
+// 1G and above
+static const int FILE_COUNTER_SIZE_BINS = 10;
+
+struct FileCounterKey {
+  const void *fhash;
+  const void *name;
+  bool operator==(const FileCounterKey &other) const {
+    return fhash == other.fhash && name == other.name;
+  }
+};
+
+struct FileCounterKeyHash {
+  size_t operator()(const FileCounterKey &key) const {
+    return std::hash<const void *>()(key.fhash) ^
+           (std::hash<const void *>()(key.name) << 1);
+  }
+};
+
+struct FileCounterRecord {
+  ConstEventNameType category;
+  uint64_t count;
+  uint64_t bytes;
+  TimeResolution total_time;
+  TimeResolution max_time;
+  TimeResolution first_start;
+  TimeResolution last_end;
+  uint64_t size_hist[FILE_COUNTER_SIZE_BINS];
+};
+
+typedef std::unordered_map<FileCounterKey, FileCounterRecord,
+                           FileCounterKeyHash>
+    FileCounterMap;
+
+/**
+ * Fixed per (file, function) counter records used instead of per call events
+ * when counter mode is enabled. Records are kept in per thread shards so that
+ * the hot path only takes an uncontended lock and are merged at finalize.
+ * The file hash and function name are interned strings, so their addresses
+ * are used as the key.
+ */
+class FileCounters {
+ private:
+  struct Shard {
+    std::mutex mtx;
+    FileCounterMap records;
+  };
+  std::mutex shards_mtx;
+  std::vector<std::shared_ptr<Shard>> shards;
+
+  Shard *local_shard();
+
+  static inline int size_bin(uint64_t size) {
+    if (size < 100) return 0;
+    if (size < 1024) return 1;
+    if (size < 10 * 1024) return 2;
+    if (size < 100 * 1024) return 3;
+    if (size < 1024 * 1024) return 4;
+    if (size < 4 * 1024 * 1024) return 5;
+    if (size < 10 * 1024 * 1024) return 6;
+    if (size < 100 * 1024 * 1024) return 7;
+    if (size < 1024 * 1024 * 1024) return 8;
+    return 9;
+  }
+
+ public:
+  static const char *size_bin_names[FILE_COUNTER_SIZE_BINS];
+
+  FileCounters() : shards_mtx(), shards() {
+    DFTRACER_LOG_DEBUG("FileCounters.FileCounters", "");
+  }
+
+  // bytes < 0 marks calls that do not transfer data
+  inline void update(HashType fhash, ConstEventNameType name,
+                     ConstEventNameType category, TimeResolution start_time,
+                     TimeResolution duration, int64_t bytes) {
+    Shard *shard = local_shard();
+    std::lock_guard<std::mutex> lock(shard->mtx);
+    FileCounterRecord &record = shard->records[FileCounterKey{fhash, name}];
+    if (record.count == 0) {
+      record.category = category;
+      record.first_start = start_time;
+    }
+    record.count++;
+    record.total_time += duration;
+    if (duration > record.max_time) record.max_time = duration;
+    record.last_end = start_time + duration;
+    if (bytes >= 0) {
+      record.bytes += bytes;
+      record.size_hist[size_bin(bytes)]++;
+    }
+  }
+
+  // merges all shards and resets them
+  FileCounterMap collect();
+
+  // in a forked child: drops the parent's counts. Only the forking thread
+  // survives, so locks held by other threads are reset instead of taken.
+  void forked();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_FILE_COUNTERS_H
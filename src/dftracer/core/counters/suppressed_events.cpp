@@ -0,0 +1,50 @@
+#include <dftracer/core/counters/suppressed_events.h>
+#include <dftracer/core/utils/posix_internal.h>
+
+template <>
+std::shared_ptr<dftracer::SuppressedEvents>
+    dftracer::Singleton<dftracer::SuppressedEvents>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::SuppressedEvents>::stop_creating_instances =
+    false;
+
+namespace dftracer {
+SuppressedEvents::Shard *SuppressedEvents::local_shard() {
+  thread_local Shard *shard = nullptr;
+  if (shard == nullptr) {
+    auto created = std::make_shared<Shard>();
+    created->tid = df_gettid();
+    std::lock_guard<std::mutex> lock(shards_mtx);
+    shards.push_back(created);
+    shard = created.get();
+  }
+  return shard;
+}
+
+// the surviving thread has a new tid, the other shards are never used again
+void SuppressedEvents::forked() {
+  new (&shards_mtx) std::mutex();
+  ThreadID tid = df_gettid();
+  for (auto &shard : shards) {
+    new (&shard->mtx) std::mutex();
+    shard->tid = tid;
+    shard->records.clear();
+  }
+}
+
+std::vector<SuppressedInterval> SuppressedEvents::collect() {
+  DFTRACER_LOG_DEBUG("SuppressedEvents.collect", "");
+  std::vector<SuppressedInterval> open_intervals;
+  std::lock_guard<std::mutex> shards_lock(shards_mtx);
+  for (auto &shard : shards) {
+    std::lock_guard<std::mutex> lock(shard->mtx);
+    for (auto &entry : shard->records) {
+      if (entry.second.count == 0) continue;
+      open_intervals.push_back(SuppressedInterval{
+          (ConstEventNameType)entry.first, shard->tid, entry.second});
+    }
+    shard->records.clear();
+  }
+  return open_intervals;
+}
+}  // namespace dftracer
@@ -0,0 +1,89 @@
+#ifndef DFTRACER_SUPPRESSED_EVENTS_H
+#define DFTRACER_SUPPRESSED_EVENTS_H
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/common/typedef.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dftracer {
+struct SuppressedRecord {
+  ConstEventNameType category;
+  TimeResolution interval;
+  uint64_t count;
+  TimeResolution total_time;
+};
+
+struct SuppressedInterval {
+  ConstEventNameType name;
+  ThreadID tid;
+  SuppressedRecord record;
+};
+
+/**
+ * Per interval accounting of events dropped for being shorter than their
+ * minimum duration. Each thread folds into its own shard; a record is handed
+ * back to the caller for writing once the thread moves on to a new interval
+ * for the same function, and whatever is left is drained at finalize.
+ */
+class SuppressedEvents {
+ private:
+  struct Shard {
+    std::mutex mtx;
+    ThreadID tid;
+    std::unordered_map<const void *, SuppressedRecord> records;
+  };
+  std::mutex shards_mtx;
+  std::vector<std::shared_ptr<Shard>> shards;
+  TimeResolution interval_us;
+
+  Shard *local_shard();
+
+ public:
+  SuppressedEvents() : shards_mtx(), shards(), interval_us(1000000) {
+    DFTRACER_LOG_DEBUG("SuppressedEvents.SuppressedEvents", "");
+  }
+
+  void set_interval(TimeResolution interval) {
+    if (interval > 0) interval_us = interval;
+  }
+
+  // returns true with the finished interval in expired when the event opens
+  // a new interval for name on this thread
+  inline bool fold(ConstEventNameType name, ConstEventNameType category,
+                   TimeResolution start_time, TimeResolution duration,
+                   SuppressedInterval &expired) {
+    Shard *shard = local_shard();
+    TimeResolution interval = start_time - start_time % interval_us;
+    std::lock_guard<std::mutex> lock(shard->mtx);
+    SuppressedRecord &record = shard->records[name];
+    bool has_expired = false;
+    if (record.count > 0 && record.interval != interval) {
+      expired.name = name;
+      expired.tid = shard->tid;
+      expired.record = record;
+      record.count = 0;
+      record.total_time = 0;
+      has_expired = true;
+    }
+    if (record.count == 0) {
+      record.category = category;
+      record.interval = interval;
+    }
+    record.count++;
+    record.total_time += duration;
+    return has_expired;
+  }
+
+  // drains the open intervals of all threads
+  std::vector<SuppressedInterval> collect();
+
+  // in a forked child: drops the parent's intervals, see FileCounters
+  void forked();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_SUPPRESSED_EVENTS_H
@@ -6,6 +6,7 @@
 #define DFTRACER_GENERIC_LOGGER_H
 
 #include <dftracer/core/buffer/buffer.h>
+#include <dftracer/core/coalescer/event_coalescer.h>
 #include <dftracer/core/common/constants.h>
 #include <dftracer/core/common/cpp_typedefs.h>
 #include <dftracer/core/common/datastructure.h>
@@ -13,6 +14,10 @@
 #include <dftracer/core/common/logging.h>
 #include <dftracer/core/common/singleton.h>
 #include <dftracer/core/common/typedef.h>
+#include <dftracer/core/counters/file_counters.h>
+#include <dftracer/core/counters/suppressed_events.h>
+#include <dftracer/core/governor/overhead_governor.h>
+#include <dftracer/core/sampling/event_sampler.h>
 #include <dftracer/core/utils/configuration_manager.h>
 #include <dftracer/core/utils/md5.h>
 #include <dftracer/core/utils/posix_internal.h>
@@ -56,6 +61,12 @@ class DFTLogger {
   std::atomic_int index;
   bool is_aggregated;
   bool has_entry;
+  // process and event that started this process, recorded in its start
+  // event as ppid and p_idx; -1 when unknown
+  ProcessID parent_pid;
+  int parent_index;
+  // current event of the parent while it forks
+  int fork_index;
 #ifdef DFTRACER_MPI_ENABLE
   bool mpi_event;
 #endif
@@ -64,6 +75,11 @@ class DFTLogger {
 #endif
   bool enable_core_affinity;
   std::shared_ptr<dftracer::BufferManager> buffer_manager;
+  std::shared_ptr<dftracer::FileCounters> file_counters;
+  std::shared_ptr<dftracer::SuppressedEvents> suppressed_events;
+  std::shared_ptr<dftracer::EventSampler> event_sampler;
+  std::shared_ptr<dftracer::OverheadGovernor> governor;
+  std::shared_ptr<dftracer::EventCoalescer> event_coalescer;
   std::vector<unsigned> core_affinity() {
     DFTRACER_LOG_DEBUG("DFTLogger.core_affinity", "");
     auto cores = std::vector<unsigned>();
@@ -83,6 +99,7 @@ class DFTLogger {
 
  public:
   bool include_metadata;
+  std::atomic<bool> counter_mode;
   DFTLogger(bool init_log = false)
       : is_init(false),
         dftracer_tid(false),
@@ -92,11 +109,15 @@ class DFTLogger {
         index(0),
         is_aggregated(false),
         has_entry(false),
+        parent_pid(-1),
+        parent_index(-1),
+        fork_index(-1),
 #ifdef DFTRACER_MPI_ENABLE
         mpi_event(false),
 #endif
         enable_core_affinity(false),
-        include_metadata(false) {
+        include_metadata(false),
+        counter_mode(false) {
     DFTRACER_LOG_DEBUG("DFTLogger.DFTLogger", "");
     config =
         dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
@@ -104,6 +125,8 @@ class DFTLogger {
     include_metadata = config->metadata;
     dftracer_tid = config->tids;
     throw_error = config->throw_error;
+    counter_mode = config->counters;
+    read_parent_context();
     if (enable_core_affinity) {
 #ifdef DFTRACER_HWLOC_ENABLE
       hwloc_topology_init(&topology);  // initialization
@@ -112,6 +135,28 @@ class DFTLogger {
     }
     buffer_manager =
         dftracer::Singleton<dftracer::BufferManager>::get_instance();
+    if (config->coalesce) {
+      event_coalescer =
+          dftracer::Singleton<dftracer::EventCoalescer>::get_instance();
+      event_coalescer->set_max_gap(config->coalesce_gap_us);
+    }
+    if (config->governor) {
+      governor =
+          dftracer::Singleton<dftracer::OverheadGovernor>::get_instance();
+    }
+    if (counter_mode || governor != nullptr) {
+      file_counters =
+          dftracer::Singleton<dftracer::FileCounters>::get_instance();
+    }
+    if (!config->min_duration.empty()) {
+      suppressed_events =
+          dftracer::Singleton<dftracer::SuppressedEvents>::get_instance();
+      suppressed_events->set_interval(config->trace_interval_ms * 1000);
+    }
+    if (!config->sampling.empty()) {
+      event_sampler =
+          dftracer::Singleton<dftracer::EventSampler>::get_instance();
+    }
     this->is_init = true;
   }
   ~DFTLogger() {
@@ -180,9 +225,14 @@ class DFTLogger {
         auto size = sprintf(timestamp, "%s", asctime(localtime(&ltime)));
         timestamp[size - 1] = '\0';
         meta->insert_or_assign("date", std::string(timestamp));
-        meta->insert_or_assign("ppid", getppid());
+        if (parent_pid == -1) meta->insert_or_assign("ppid", getppid());
         this->buffer_manager->set_app_name(exec_name.c_str());
       }
+      if (parent_pid != -1) {
+        if (meta == nullptr) meta = new dftracer::Metadata();
+        meta->insert_or_assign("ppid", parent_pid);
+        meta->insert_or_assign("p_idx", parent_index);
+      }
       this->enter_event();
       this->log("start", "dftracer", this->get_time(), 0, meta);
       this->exit_event();
@@ -213,6 +263,64 @@ class DFTLogger {
     DFTRACER_LOG_INFO("Writing trace to %s", log_file.c_str());
   }
 
+  // an image started by exec takes the context exported by the image
+  // before it; the pid check drops values inherited from further up as
+  // the variable is removed once read
+  inline void read_parent_context() {
+    const char *context = getenv(DFTRACER_PARENT_CONTEXT);
+    if (context == nullptr) return;
+    int pid = -1, event_index = -1;
+    if (sscanf(context, "%d:%d", &pid, &event_index) == 2 &&
+        (pid == getpid() || pid == getppid())) {
+      parent_pid = pid;
+      parent_index = event_index;
+    }
+    unsetenv(DFTRACER_PARENT_CONTEXT);
+  }
+
+  // value of DFTRACER_PARENT_CONTEXT for an exec from the current event
+  inline std::string parent_context() {
+    return std::to_string(df_getpid()) + ":" + std::to_string(get_current());
+  }
+
+  // fork handlers, see BufferManager
+  inline void prepare_fork() {
+    fork_index = get_current();
+    if (this->buffer_manager != nullptr) this->buffer_manager->prepare_fork();
+  }
+
+  inline void parent_after_fork() {
+    if (this->buffer_manager != nullptr) {
+      this->buffer_manager->parent_after_fork();
+    }
+  }
+
+  // the child starts with fresh event indices, hash cache and pending
+  // per thread state and records the event its parent forked in;
+  // update_log_file then opens its own trace. The event stack is kept as
+  // the forking thread still exits the events it is in. Hash strings are
+  // not freed as the fd tables still point at them.
+  inline void child_after_fork() {
+    if (this->buffer_manager != nullptr) {
+      this->buffer_manager->child_after_fork();
+    }
+    new (&level_mtx) std::shared_mutex();
+    new (&map_mtx) std::shared_mutex();
+    index = 0;
+    computed_hash.clear();
+    has_entry = false;
+#ifdef DFTRACER_MPI_ENABLE
+    mpi_event = false;
+#endif
+    if (event_coalescer != nullptr) event_coalescer->forked();
+    if (file_counters != nullptr) file_counters->forked();
+    if (suppressed_events != nullptr) suppressed_events->forked();
+    if (event_sampler != nullptr) event_sampler->forked();
+    parent_pid = this->process_id;
+    parent_index = fork_index;
+    this->process_id = df_getpid();
+  }
+
   inline void clean_stack() {
     std::unique_lock<std::shared_mutex> lock(level_mtx);
     index_stack.clear();
@@ -300,6 +408,8 @@ class DFTLogger {
                   TimeResolution start_time, TimeResolution duration,
                   dftracer::Metadata *metadata) {
     DFTRACER_LOG_DEBUG("DFTLogger.log", "");
+    uint64_t govern_start =
+        governor != nullptr ? dftracer::OverheadGovernor::now_ns() : 0;
 
     // Get thread id and process id from metadata if it exists
     ThreadID tid = 0;
@@ -323,22 +433,229 @@ class DFTLogger {
     if (metadata != nullptr && !is_aggregated) {
       metadata->insert_or_assign("level", level);
       int parent_index_value = get_parent();
-      metadata->insert_or_assign("p_idx", parent_index_value);
+      // the start event keeps the p_idx of its parent process
+      metadata->insert("p_idx", parent_index_value);
     }
     handle_mpi(tid);
-    if (include_metadata) {
-      int current_index = get_current();
-      this->buffer_manager->log_data_event(current_index, event_name, category,
-                                           start_time, duration, metadata,
-                                           this->process_id, tid);
-    } else {
-      this->buffer_manager->log_data_event(local_index, event_name, category,
-                                           start_time, duration, metadata,
-                                           this->process_id, tid);
+    int event_index = include_metadata ? get_current() : local_index;
+    if (event_coalescer != nullptr) flush_coalesced();
+    write_event(event_index, event_name, category, start_time, duration,
+                metadata, tid);
+    if (governor != nullptr) govern(govern_start);
+  }
+
+  inline bool coalesce_io() const { return event_coalescer != nullptr; }
+
+  // log() for reads and writes that may be merged by the coalescer, offset
+  // is -1 for calls using the file position
+  inline void log_io(ConstEventNameType event_name,
+                     ConstEventNameType category, TimeResolution start_time,
+                     TimeResolution duration, dftracer::Metadata *metadata,
+                     HashType fhash, int fd, int64_t offset, int64_t bytes) {
+    DFTRACER_LOG_DEBUG("DFTLogger.log_io", "");
+    uint64_t govern_start =
+        governor != nullptr ? dftracer::OverheadGovernor::now_ns() : 0;
+    ThreadID tid = dftracer_tid ? df_gettid() : 0;
+    int event_index = include_metadata ? get_current() : index.load();
+    if (metadata != nullptr && !is_aggregated) {
+      metadata->insert_or_assign("level", level);
+      int parent_index_value = get_parent();
+      metadata->insert("p_idx", parent_index_value);
+    }
+    handle_mpi(tid);
+    dftracer::CoalescedEvent event{event_index,
+                                   tid,
+                                   event_name,
+                                   category,
+                                   start_time,
+                                   start_time + duration,
+                                   metadata,
+                                   fhash,
+                                   fd,
+                                   offset < 0 ? -1 : offset + bytes,
+                                   (uint64_t)bytes,
+                                   1};
+    dftracer::CoalescedEvent flushed;
+    if (event_coalescer->add(event, flushed)) log_coalesced(flushed);
+    if (governor != nullptr) govern(govern_start);
+  }
+
+  inline void flush_coalesced() {
+    dftracer::CoalescedEvent flushed;
+    if (event_coalescer->flush_local(flushed)) log_coalesced(flushed);
+  }
+
+  // count and ret of the first call would understate a run, they are
+  // replaced by the bytes moved by all of its calls
+  inline void log_coalesced(dftracer::CoalescedEvent &event) {
+    if (event.metadata != nullptr && event.ops > 1) {
+      event.metadata->insert_or_assign("ops", event.ops,
+                                       MetadataType::MT_VALUE);
+      event.metadata->insert_or_assign("bytes", event.bytes,
+                                       MetadataType::MT_VALUE);
+      event.metadata->insert_or_assign("count", event.bytes,
+                                       MetadataType::MT_VALUE);
+      event.metadata->insert_or_assign("ret", event.bytes,
+                                       MetadataType::MT_VALUE);
     }
+    write_event(event.index, event.name, event.category, event.start_time,
+                event.end_time - event.start_time, event.metadata, event.tid);
+  }
+
+  // samples and serializes an event that already carries its index and tid
+  inline void write_event(int event_index, ConstEventNameType event_name,
+                          ConstEventNameType category,
+                          TimeResolution start_time, TimeResolution duration,
+                          dftracer::Metadata *metadata, ThreadID tid) {
+    if (event_sampler != nullptr) {
+      double weight = 0;
+      std::vector<dftracer::SampledEvent> ready;
+      bool keep = event_sampler->offer(event_index, event_name, category,
+                                       start_time, duration, metadata, tid,
+                                       weight, ready);
+      for (auto &event : ready) log_sampled(event);
+      if (!keep) return;
+      if (metadata != nullptr && weight > 0) {
+        metadata->insert_or_assign("weight", weight);
+      }
+    }
+    this->buffer_manager->log_data_event(event_index, event_name, category,
+                                         start_time, duration, metadata,
+                                         this->process_id, tid);
+    has_entry = true;
+  }
+
+  inline void govern(uint64_t begin_ns) {
+    dftracer::GovernorTransition transition;
+    if (governor->record(begin_ns, dftracer::OverheadGovernor::now_ns(),
+                         transition)) {
+      apply_governor(transition);
+    }
+  }
+
+  // switches the output mode to the governor's level and records the change
+  inline void apply_governor(const dftracer::GovernorTransition &transition) {
+    auto level = transition.to;
+    counter_mode =
+        config->counters || level >= GovernorLevel::GOVERNOR_LEVEL_COUNTERS;
+    this->buffer_manager->set_aggregation(
+        config->aggregation_enable ||
+            level >= GovernorLevel::GOVERNOR_LEVEL_AGGREGATED,
+        index.load(), this->process_id);
+    char value[256];
+    snprintf(value, sizeof(value),
+             "from=%s,to=%s,ts=%llu,events_per_sec=%lu,overhead_ppm=%lu",
+             to_string(transition.from).c_str(),
+             to_string(transition.to).c_str(), this->get_time(),
+             (unsigned long)transition.events_per_sec,
+             (unsigned long)transition.overhead_ppm);
+    ThreadID tid = dftracer_tid ? df_gettid() : 0;
+    this->buffer_manager->log_metadata_event("governor", value,
+                                             CUSTOM_METADATA,
+                                             this->process_id, tid);
+  }
+
+  // writes an event released by a sampling reservoir
+  inline void log_sampled(dftracer::SampledEvent &event) {
+    if (event.metadata != nullptr) {
+      event.metadata->insert_or_assign("weight", event.weight);
+    }
+    this->buffer_manager->log_data_event(
+        event.index, event.name.c_str(), event.category.c_str(),
+        event.start_time, event.duration, event.metadata, this->process_id,
+        event.tid);
     has_entry = true;
   }
 
+  // counter mode replacement of log() for calls on traced files
+  inline void count(HashType fhash, ConstEventNameType event_name,
+                    ConstEventNameType category, TimeResolution start_time,
+                    TimeResolution duration, int64_t bytes) {
+    uint64_t govern_start =
+        governor != nullptr ? dftracer::OverheadGovernor::now_ns() : 0;
+    file_counters->update(fhash, event_name, category, start_time, duration,
+                          bytes);
+    has_entry = true;
+    if (governor != nullptr) govern(govern_start);
+  }
+
+  // writes one counter event per (file, function) collected in counter mode
+  inline void log_counters() {
+    DFTRACER_LOG_DEBUG("DFTLogger.log_counters", "");
+    if (file_counters == nullptr) return;
+    auto records = file_counters->collect();
+    int rank = this->buffer_manager->get_rank();
+    for (auto &entry : records) {
+      const dftracer::FileCounterRecord &record = entry.second;
+      auto meta = new dftracer::Metadata();
+      meta->insert_or_assign("fhash", (HashType)entry.first.fhash);
+      meta->insert_or_assign("rank", rank);
+      meta->insert_or_assign("count", record.count, MetadataType::MT_VALUE);
+      meta->insert_or_assign("total_time", record.total_time,
+                             MetadataType::MT_VALUE);
+      meta->insert_or_assign("max_time", record.max_time,
+                             MetadataType::MT_VALUE);
+      meta->insert_or_assign("first_start", record.first_start,
+                             MetadataType::MT_VALUE);
+      meta->insert_or_assign("last_end", record.last_end,
+                             MetadataType::MT_VALUE);
+      uint64_t data_ops = 0;
+      for (int bin = 0; bin < dftracer::FILE_COUNTER_SIZE_BINS; ++bin) {
+        data_ops += record.size_hist[bin];
+      }
+      if (data_ops > 0) {
+        meta->insert_or_assign("bytes", record.bytes, MetadataType::MT_VALUE);
+        for (int bin = 0; bin < dftracer::FILE_COUNTER_SIZE_BINS; ++bin) {
+          meta->insert_or_assign(dftracer::FileCounters::size_bin_names[bin],
+                                 record.size_hist[bin],
+                                 MetadataType::MT_VALUE);
+        }
+      }
+      this->buffer_manager->log_counter_event(
+          index++, (ConstEventNameType)entry.first.name, record.category,
+          record.first_start, this->process_id, 0, meta);
+    }
+  }
+
+  // threshold below which events of a function are dropped, function names
+  // take precedence over their category
+  inline TimeResolution min_duration(ConstEventNameType event_name,
+                                     ConstEventNameType category) {
+    if (suppressed_events == nullptr) return 0;
+    auto iter = config->min_duration.find(event_name);
+    if (iter == config->min_duration.end()) {
+      iter = config->min_duration.find(category);
+      if (iter == config->min_duration.end()) return 0;
+    }
+    return iter->second;
+  }
+
+  // replaces log() for events below their minimum duration
+  inline void suppress(ConstEventNameType event_name,
+                       ConstEventNameType category, TimeResolution start_time,
+                       TimeResolution duration, dftracer::Metadata *metadata) {
+    if (metadata != nullptr) delete metadata;
+    // a dropped lseek may still move the file position of a run
+    if (event_coalescer != nullptr) flush_coalesced();
+    dftracer::SuppressedInterval expired;
+    if (suppressed_events->fold(event_name, category, start_time, duration,
+                                expired)) {
+      log_suppressed(expired);
+    }
+  }
+
+  inline void log_suppressed(const dftracer::SuppressedInterval &suppressed) {
+    auto meta = new dftracer::Metadata();
+    meta->insert_or_assign("suppressed", suppressed.record.count,
+                           MetadataType::MT_VALUE);
+    meta->insert_or_assign("suppressed_time", suppressed.record.total_time,
+                           MetadataType::MT_VALUE);
+    ThreadID tid = dftracer_tid ? suppressed.tid : 0;
+    this->buffer_manager->log_counter_event(
+        index++, suppressed.name, suppressed.record.category,
+        suppressed.record.interval, this->process_id, tid, meta);
+  }
+
   inline void log_metadata(ConstEventNameType key, ConstEventNameType value) {
     DFTRACER_LOG_DEBUG("DFTLogger.log_metadata", "");
     ThreadID tid = 0;
@@ -404,9 +721,22 @@ class DFTLogger {
     return hash_and_store_str(file, name);
   }
 
+  inline void dump_flight_recorder(const char *reason) {
+    if (this->buffer_manager != nullptr) {
+      ThreadID tid = dftracer_tid ? df_gettid() : 0;
+      this->buffer_manager->dump_flight_recorder(reason, this->process_id, tid);
+    }
+  }
+
   inline void finalize() {
     DFTRACER_LOG_DEBUG("DFTLogger.finalize", "");
     if (this->buffer_manager != nullptr) {
+      if (event_coalescer != nullptr) {
+        for (auto &event : event_coalescer->collect()) log_coalesced(event);
+      }
+      if (event_sampler != nullptr) {
+        for (auto &event : event_sampler->collect()) log_sampled(event);
+      }
       auto meta = new dftracer::Metadata();
       meta->insert_or_assign("num_events", index.load());
       int current_index = this->enter_event();
@@ -415,6 +745,12 @@ class DFTLogger {
                                            this->get_time(), 0, meta,
                                            this->process_id, tid);
       this->exit_event();
+      log_counters();
+      if (suppressed_events != nullptr) {
+        for (auto &suppressed : suppressed_events->collect()) {
+          log_suppressed(suppressed);
+        }
+      }
       this->buffer_manager->finalize(index.load(), this->process_id, true);
       DFTRACER_LOG_INFO("Released Logger", "");
       this->buffer_manager.reset();
@@ -429,28 +765,48 @@ class DFTLogger {
 #define DFT_LOGGER_INIT() dftracer::Singleton<DFTLogger>::get_instance()
 #define DFT_LOGGER_FINI() \
   dftracer::Singleton<DFTLogger>::get_instance()->finalize()
-#define DFT_LOGGER_UPDATE(value)               \
-  if (trace && this->logger->include_metadata) \
+#define DFT_LOGGER_UPDATE(value)                       \
+  if (trace && metadata != nullptr)                    \
     metadata->insert_or_assign(#value, value);
 
-#define DFT_LOGGER_UPDATE_TYPE(value, type)    \
-  if (trace && this->logger->include_metadata) \
+#define DFT_LOGGER_UPDATE_TYPE(value, type)            \
+  if (trace && metadata != nullptr)                    \
     metadata->insert_or_assign(#value, value, type);
 
 #define DFT_LOGGER_UPDATE_HASH(value)                                 \
-  if (trace && this->logger->include_metadata) {                      \
+  if (trace && metadata != nullptr) {                                 \
     HashType value##_hash =                                           \
         this->logger->hash_and_store(value, METADATA_NAME_FILE_HASH); \
     DFT_LOGGER_UPDATE(value##_hash);                                  \
   }
 
-#define DFT_LOGGER_START(entity)                           \
+// bytes moved by the call, used by the counter mode
+#define DFT_LOGGER_UPDATE_BYTES(value) dft_bytes = value;
+
+// fd, offset (-1 for the file position) and bytes of a read or write, used
+// by the counter mode and the coalescer
+#define DFT_LOGGER_UPDATE_IO(fd, offset, bytes) \
+  dft_fd = fd;                                  \
+  dft_offset = offset;                          \
+  dft_bytes = bytes;
+
+#define DFT_LOGGER_START(entity) \
+  DFT_LOGGER_START_HASH(is_traced(entity, __FUNCTION__))
+// in counter mode traced calls only take the start time, the call is folded
+// into the per file counters at DFT_LOGGER_END
+#define DFT_LOGGER_START_HASH(hash)                        \
   DFTRACER_LOG_DEBUG("Calling function %s", __FUNCTION__); \
-  HashType fhash = is_traced(entity, __FUNCTION__);        \
+  HashType fhash = hash;                                   \
   bool trace = fhash != NO_HASH_DEFAULT;                   \
+  bool dft_counted = trace && this->logger->counter_mode;  \
+  int dft_fd = -1;                                         \
+  int64_t dft_offset = -1;                                 \
+  int64_t dft_bytes = -1;                                  \
   TimeResolution start_time = 0;                           \
   dftracer::Metadata *metadata = nullptr;                  \
-  if (trace) {                                             \
+  if (dft_counted) {                                       \
+    start_time = this->logger->get_time();                 \
+  } else if (trace) {                                      \
     if (this->logger->include_metadata) {                  \
       metadata = new dftracer::Metadata();                 \
       DFT_LOGGER_UPDATE(fhash);                            \
@@ -460,7 +816,12 @@ class DFTLogger {
   }
 #define DFT_LOGGER_START_ALWAYS()                          \
   DFTRACER_LOG_DEBUG("Calling function %s", __FUNCTION__); \
+  HashType fhash = NO_HASH_DEFAULT;                        \
   bool trace = true;                                       \
+  bool dft_counted = false;                                \
+  int dft_fd = -1;                                         \
+  int64_t dft_offset = -1;                                 \
+  int64_t dft_bytes = -1;                                  \
   TimeResolution start_time = 0;                           \
   dftracer::Metadata *metadata = nullptr;                  \
   if (trace) {                                             \
@@ -470,12 +831,32 @@ class DFTLogger {
     this->logger->enter_event();                           \
     start_time = this->logger->get_time();                 \
   }
-#define DFT_LOGGER_END()                                          \
-  if (trace) {                                                    \
-    TimeResolution end_time = this->logger->get_time();           \
-    this->logger->log((char *)__FUNCTION__, CATEGORY, start_time, \
-                      end_time - start_time, metadata);           \
-    this->logger->exit_event();                                   \
+#define DFT_LOGGER_END() DFT_LOGGER_END_AT(this->logger->get_time())
+// ends the event at a time taken earlier so that work done after the call
+// (e.g. sampling extra metadata) is not charged to it. The minimum duration
+// of each call site is looked up once.
+#define DFT_LOGGER_END_AT(end)                                          \
+  if (dft_counted) {                                                    \
+    TimeResolution end_time = end;                                      \
+    this->logger->count(fhash, (char *)__FUNCTION__, CATEGORY,          \
+                        start_time, end_time - start_time, dft_bytes);  \
+  } else if (trace) {                                                   \
+    TimeResolution end_time = end;                                      \
+    static const TimeResolution dft_min_duration =                      \
+        this->logger->min_duration(__FUNCTION__, CATEGORY);             \
+    if (end_time - start_time < dft_min_duration) {                     \
+      this->logger->suppress((char *)__FUNCTION__, CATEGORY, start_time, \
+                             end_time - start_time, metadata);          \
+    } else if (dft_fd >= 0 && dft_bytes > 0 &&                          \
+               this->logger->coalesce_io()) {                           \
+      this->logger->log_io((char *)__FUNCTION__, CATEGORY, start_time,  \
+                           end_time - start_time, metadata, fhash,      \
+                           dft_fd, dft_offset, dft_bytes);              \
+    } else {                                                            \
+      this->logger->log((char *)__FUNCTION__, CATEGORY, start_time,     \
+                        end_time - start_time, metadata);               \
+    }                                                                   \
+    this->logger->exit_event();                                         \
   }
 
 #endif  // DFTRACER_GENERIC_LOGGER_H
@@ -168,6 +168,17 @@ void log_event(ConstEventNameType name, ConstEventNameType cat,
     DFTRACER_LOG_ERROR("dftracer.cpp.log_event dftracer not initialized", "");
 }
 
+void dump_flight_recorder() {
+  DFTRACER_LOG_DEBUG("dftracer.cpp.dump_flight_recorder", "");
+  auto dftracer = DFTRACER_MAIN_SINGLETON(ProfilerStage::PROFILER_OTHER,
+                                          ProfileType::PROFILER_C_APP);
+  if (dftracer != nullptr)
+    dftracer->dump_flight_recorder("api");
+  else
+    DFTRACER_LOG_ERROR(
+        "dftracer.cpp.dump_flight_recorder dftracer not initialized", "");
+}
+
 void finalize() {
   DFTRACER_LOG_DEBUG("dftracer.cpp.finalize", "");
   auto dftracer = DFTRACER_MAIN_SINGLETON(ProfilerStage::PROFILER_FINI,
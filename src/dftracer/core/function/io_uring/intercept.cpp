@@ -0,0 +1,460 @@
+#include <dftracer/core/function/io_uring/intercept.h>
+#ifdef DFTRACER_IO_URING_TRACING_ENABLE
+
+#include <dftracer/core/brahma/gotcha_binding.h>
+#include <dftracer/core/brahma/posix.h>
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/utils/configuration_manager.h>
+
+static ConstEventNameType CATEGORY = "IO_URING";
+
+template <>
+std::shared_ptr<dftracer::IOUringFunction>
+    dftracer::Singleton<dftracer::IOUringFunction>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::IOUringFunction>::stop_creating_instances =
+    false;
+bool dftracer::IOUringFunction::stop_trace = false;
+
+DFT_GOTCHA_DECL(io_uring_submit, int, (struct io_uring *));
+DFT_GOTCHA_DECL(io_uring_submit_and_wait, int, (struct io_uring *, unsigned));
+DFT_GOTCHA_DECL(io_uring_submit_and_wait_timeout, int,
+                (struct io_uring *, struct io_uring_cqe **, unsigned,
+                 struct __kernel_timespec *, sigset_t *));
+DFT_GOTCHA_DECL(__io_uring_get_cqe, int,
+                (struct io_uring *, struct io_uring_cqe **, unsigned, unsigned,
+                 sigset_t *));
+DFT_GOTCHA_DECL(io_uring_wait_cqes, int,
+                (struct io_uring *, struct io_uring_cqe **, unsigned,
+                 struct __kernel_timespec *, sigset_t *));
+DFT_GOTCHA_DECL(io_uring_wait_cqe_timeout, int,
+                (struct io_uring *, struct io_uring_cqe **,
+                 struct __kernel_timespec *));
+DFT_GOTCHA_DECL(io_uring_peek_batch_cqe, unsigned,
+                (struct io_uring *, struct io_uring_cqe **, unsigned));
+DFT_GOTCHA_DECL(io_uring_enter, int,
+                (unsigned int, unsigned int, unsigned int, unsigned int,
+                 sigset_t *));
+DFT_GOTCHA_DECL(io_uring_register_files, int,
+                (struct io_uring *, const int *, unsigned));
+DFT_GOTCHA_DECL(io_uring_unregister_files, int, (struct io_uring *));
+DFT_GOTCHA_DECL(io_uring_queue_exit, void, (struct io_uring *));
+
+static ConstEventNameType opcode_name(uint8_t opcode) {
+  switch (opcode) {
+    case IORING_OP_READV:
+      return "io_uring_readv";
+    case IORING_OP_WRITEV:
+      return "io_uring_writev";
+    case IORING_OP_FSYNC:
+      return "io_uring_fsync";
+    case IORING_OP_READ_FIXED:
+      return "io_uring_read_fixed";
+    case IORING_OP_WRITE_FIXED:
+      return "io_uring_write_fixed";
+    case IORING_OP_SYNC_FILE_RANGE:
+      return "io_uring_sync_file_range";
+    case IORING_OP_FALLOCATE:
+      return "io_uring_fallocate";
+    case IORING_OP_CLOSE:
+      return "io_uring_close";
+    case IORING_OP_STATX:
+      return "io_uring_statx";
+    case IORING_OP_READ:
+      return "io_uring_read";
+    case IORING_OP_WRITE:
+      return "io_uring_write";
+    case IORING_OP_FADVISE:
+      return "io_uring_fadvise";
+    case IORING_OP_SPLICE:
+      return "io_uring_splice";
+    default:
+      return "io_uring_op";
+  }
+}
+
+namespace dftracer {
+
+std::shared_ptr<IOUringFunction> IOUringFunction::get_active_instance() {
+  if (stop_trace) return nullptr;
+  return dftracer::Singleton<IOUringFunction>::get_instance();
+}
+
+HashType IOUringFunction::get_hash(RingState &state,
+                                   const struct io_uring_sqe *sqe) {
+  int fd = sqe->fd;
+  if (sqe->flags & IOSQE_FIXED_FILE) {
+    if (fd < 0 || (size_t)fd >= state.fixed_files.size())
+      return NO_HASH_DEFAULT;
+    fd = state.fixed_files[fd];
+  }
+  auto posix = brahma::POSIXDFTracer::get_active_instance();
+  if (posix == nullptr) return NO_HASH_DEFAULT;
+  return posix->get_fd_hash(fd);
+}
+
+// index of the next SQE the kernel takes: with SQPOLL whatever liburing
+// flushed to the tail, otherwise io_uring_enter consumes from the head
+static unsigned sq_index(struct io_uring *ring) {
+  if (ring->flags & IORING_SETUP_SQPOLL)
+    return __atomic_load_n(ring->sq.ktail, __ATOMIC_ACQUIRE);
+  return __atomic_load_n(ring->sq.khead, __ATOMIC_ACQUIRE);
+}
+
+// copies the SQEs the next call may hand to the kernel, as the application
+// reuses their slots once they are consumed; returns the index of the first
+unsigned IOUringFunction::queued_submissions(
+    struct io_uring *ring, std::vector<struct io_uring_sqe> &sqes) {
+  unsigned first = sq_index(ring);
+  unsigned tail = ring->sq.sqe_tail;
+  if (tail - first > *ring->sq.kring_entries) return first;
+  unsigned mask = *ring->sq.kring_mask;
+  unsigned shift = (ring->flags & IORING_SETUP_SQE128) ? 1 : 0;
+  sqes.reserve(tail - first);
+  for (unsigned i = first; i != tail; ++i) {
+    sqes.push_back(ring->sq.sqes[(i & mask) << shift]);
+  }
+  return first;
+}
+
+// records the first consumed of the queued SQEs; the rest stay queued and
+// are captured by the call that submits them
+size_t IOUringFunction::capture_submissions(
+    struct io_uring *ring, const std::vector<struct io_uring_sqe> &sqes,
+    size_t consumed, TimeResolution submit_time) {
+  if (consumed > sqes.size()) consumed = sqes.size();
+  if (consumed == 0) return 0;
+  size_t traced = 0;
+  std::lock_guard<std::mutex> lock(mtx);
+  auto &state = rings[ring];
+  for (size_t i = 0; i < consumed; ++i) {
+    const struct io_uring_sqe *sqe = &sqes[i];
+    HashType fhash = get_hash(state, sqe);
+    if (fhash == NO_HASH_DEFAULT) continue;
+    if (state.num_pending >= MAX_PENDING) {
+      DFTRACER_LOG_WARN("IOUringFunction dropping SQE with %lu pending",
+                        state.num_pending);
+      continue;
+    }
+    PendingIO io;
+    io.submit_time = submit_time;
+    io.fhash = fhash;
+    io.opcode = sqe->opcode;
+    io.len = sqe->len;
+    io.offset = sqe->off;
+    io.depth = sqes.size();
+    state.pending[sqe->user_data].push_back(io);
+    state.num_pending++;
+    traced++;
+  }
+  return traced;
+}
+
+void IOUringFunction::reap_completions(struct io_uring *ring) {
+  std::vector<std::pair<PendingIO, int>> completed;
+  TimeResolution end_time = 0;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto iter = rings.find(ring);
+    if (iter == rings.end()) return;
+    auto &state = iter->second;
+    unsigned head = __atomic_load_n(ring->cq.khead, __ATOMIC_ACQUIRE);
+    unsigned tail = __atomic_load_n(ring->cq.ktail, __ATOMIC_ACQUIRE);
+    unsigned first = head;
+    if (state.cq_scanned - head <= tail - head) first = state.cq_scanned;
+    state.cq_scanned = tail;
+    if (state.num_pending == 0) return;
+    unsigned mask = *ring->cq.kring_mask;
+    unsigned shift = (ring->flags & IORING_SETUP_CQE32) ? 1 : 0;
+    end_time = logger->get_time();
+    for (unsigned i = first; i != tail; ++i) {
+      const struct io_uring_cqe *cqe = &ring->cq.cqes[(i & mask) << shift];
+      auto pending = state.pending.find(cqe->user_data);
+      if (pending == state.pending.end()) continue;
+      completed.emplace_back(pending->second.front(), cqe->res);
+      pending->second.pop_front();
+      if (pending->second.empty()) state.pending.erase(pending);
+      state.num_pending--;
+    }
+  }
+  for (const auto &item : completed) log_io(item.first, item.second, end_time);
+}
+
+void IOUringFunction::log_io(const PendingIO &io, int ret,
+                             TimeResolution end_time) {
+  dftracer::Metadata *metadata = nullptr;
+  if (logger->include_metadata) {
+    metadata = new dftracer::Metadata();
+    metadata->insert_or_assign("fhash", io.fhash);
+    metadata->insert_or_assign("opcode", (unsigned int)io.opcode);
+    size_t count = io.len;
+    metadata->insert_or_assign("count", count, MetadataType::MT_VALUE);
+    off64_t offset = io.offset;
+    metadata->insert_or_assign("offset", offset, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("depth", io.depth, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("ret", ret, MetadataType::MT_VALUE);
+  }
+  logger->enter_event();
+  logger->log(opcode_name(io.opcode), CATEGORY, io.submit_time,
+              end_time - io.submit_time, metadata);
+  logger->exit_event();
+}
+
+void IOUringFunction::log_submit(ConstEventNameType name,
+                                 TimeResolution start_time, unsigned depth,
+                                 size_t traced, int ret) {
+  dftracer::Metadata *metadata = nullptr;
+  if (logger->include_metadata) {
+    metadata = new dftracer::Metadata();
+    metadata->insert_or_assign("depth", depth, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("traced", traced, MetadataType::MT_VALUE);
+    metadata->insert_or_assign("ret", ret, MetadataType::MT_VALUE);
+  }
+  TimeResolution end_time = logger->get_time();
+  logger->enter_event();
+  logger->log(name, CATEGORY, start_time, end_time - start_time, metadata);
+  logger->exit_event();
+}
+
+int IOUringFunction::io_uring_submit(struct io_uring *ring) {
+  DFT_MAP_OR_FAIL(io_uring_submit);
+  std::vector<struct io_uring_sqe> sqes;
+  queued_submissions(ring, sqes);
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_submit(ring);
+  size_t traced =
+      capture_submissions(ring, sqes, ret > 0 ? ret : 0, start_time);
+  if (traced > 0)
+    log_submit(__FUNCTION__, start_time, sqes.size(), traced, ret);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::io_uring_submit_and_wait(struct io_uring *ring,
+                                              unsigned wait_nr) {
+  DFT_MAP_OR_FAIL(io_uring_submit_and_wait);
+  std::vector<struct io_uring_sqe> sqes;
+  queued_submissions(ring, sqes);
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_submit_and_wait(ring, wait_nr);
+  size_t traced =
+      capture_submissions(ring, sqes, ret > 0 ? ret : 0, start_time);
+  if (traced > 0)
+    log_submit(__FUNCTION__, start_time, sqes.size(), traced, ret);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::io_uring_submit_and_wait_timeout(
+    struct io_uring *ring, struct io_uring_cqe **cqe_ptr, unsigned wait_nr,
+    struct __kernel_timespec *ts, sigset_t *sigmask) {
+  DFT_MAP_OR_FAIL(io_uring_submit_and_wait_timeout);
+  std::vector<struct io_uring_sqe> sqes;
+  queued_submissions(ring, sqes);
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_submit_and_wait_timeout(ring, cqe_ptr, wait_nr, ts,
+                                                    sigmask);
+  size_t traced =
+      capture_submissions(ring, sqes, ret > 0 ? ret : 0, start_time);
+  if (traced > 0)
+    log_submit(__FUNCTION__, start_time, sqes.size(), traced, ret);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::__io_uring_get_cqe(struct io_uring *ring,
+                                        struct io_uring_cqe **cqe_ptr,
+                                        unsigned submit, unsigned wait_nr,
+                                        sigset_t *sigmask) {
+  DFT_MAP_OR_FAIL(__io_uring_get_cqe);
+  // returns 0 or an error rather than a count, the SQ index tells how many
+  // SQEs the kernel took
+  std::vector<struct io_uring_sqe> sqes;
+  unsigned first = submit > 0 ? queued_submissions(ring, sqes) : 0;
+  TimeResolution start_time = logger->get_time();
+  int ret = __real___io_uring_get_cqe(ring, cqe_ptr, submit, wait_nr, sigmask);
+  if (submit > 0)
+    capture_submissions(ring, sqes, sq_index(ring) - first, start_time);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::io_uring_wait_cqes(struct io_uring *ring,
+                                        struct io_uring_cqe **cqe_ptr,
+                                        unsigned wait_nr,
+                                        struct __kernel_timespec *ts,
+                                        sigset_t *sigmask) {
+  DFT_MAP_OR_FAIL(io_uring_wait_cqes);
+  // without IORING_FEAT_EXT_ARG the timeout is queued through a NOP SQE,
+  // which flushes whatever else is queued
+  std::vector<struct io_uring_sqe> sqes;
+  unsigned first = queued_submissions(ring, sqes);
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_wait_cqes(ring, cqe_ptr, wait_nr, ts, sigmask);
+  capture_submissions(ring, sqes, sq_index(ring) - first, start_time);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::io_uring_wait_cqe_timeout(struct io_uring *ring,
+                                               struct io_uring_cqe **cqe_ptr,
+                                               struct __kernel_timespec *ts) {
+  DFT_MAP_OR_FAIL(io_uring_wait_cqe_timeout);
+  std::vector<struct io_uring_sqe> sqes;
+  unsigned first = queued_submissions(ring, sqes);
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_wait_cqe_timeout(ring, cqe_ptr, ts);
+  capture_submissions(ring, sqes, sq_index(ring) - first, start_time);
+  reap_completions(ring);
+  return ret;
+}
+
+unsigned IOUringFunction::io_uring_peek_batch_cqe(struct io_uring *ring,
+                                                  struct io_uring_cqe **cqes,
+                                                  unsigned count) {
+  DFT_MAP_OR_FAIL(io_uring_peek_batch_cqe);
+  unsigned ret = __real_io_uring_peek_batch_cqe(ring, cqes, count);
+  reap_completions(ring);
+  return ret;
+}
+
+int IOUringFunction::io_uring_enter(unsigned int fd, unsigned int to_submit,
+                                    unsigned int min_complete,
+                                    unsigned int flags, sigset_t *sig) {
+  DFT_MAP_OR_FAIL(io_uring_enter);
+  struct io_uring *ring = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &item : rings) {
+      if (item.first->ring_fd == (int)fd) {
+        ring = item.first;
+        break;
+      }
+    }
+  }
+  TimeResolution start_time = logger->get_time();
+  int ret = __real_io_uring_enter(fd, to_submit, min_complete, flags, sig);
+  if (ring != nullptr) {
+    if (to_submit > 0) log_submit(__FUNCTION__, start_time, to_submit, 0, ret);
+    reap_completions(ring);
+  }
+  return ret;
+}
+
+int IOUringFunction::io_uring_register_files(struct io_uring *ring,
+                                             const int *files,
+                                             unsigned nr_files) {
+  DFT_MAP_OR_FAIL(io_uring_register_files);
+  int ret = __real_io_uring_register_files(ring, files, nr_files);
+  if (ret == 0 && files != nullptr) {
+    std::lock_guard<std::mutex> lock(mtx);
+    rings[ring].fixed_files.assign(files, files + nr_files);
+  }
+  return ret;
+}
+
+int IOUringFunction::io_uring_unregister_files(struct io_uring *ring) {
+  DFT_MAP_OR_FAIL(io_uring_unregister_files);
+  int ret = __real_io_uring_unregister_files(ring);
+  if (ret == 0) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto iter = rings.find(ring);
+    if (iter != rings.end()) iter->second.fixed_files.clear();
+  }
+  return ret;
+}
+
+void IOUringFunction::io_uring_queue_exit(struct io_uring *ring) {
+  DFT_MAP_OR_FAIL(io_uring_queue_exit);
+  reap_completions(ring);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto iter = rings.find(ring);
+    if (iter != rings.end()) {
+      DFTRACER_LOG_DEBUG("IOUringFunction dropping %lu pending requests",
+                         iter->second.num_pending);
+      rings.erase(iter);
+    }
+  }
+  __real_io_uring_queue_exit(ring);
+}
+
+}  // namespace dftracer
+
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_submit,
+                   (struct io_uring * ring), (ring))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_submit_and_wait,
+                   (struct io_uring * ring, unsigned wait_nr), (ring, wait_nr))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int,
+                   io_uring_submit_and_wait_timeout,
+                   (struct io_uring * ring, struct io_uring_cqe **cqe_ptr,
+                    unsigned wait_nr, struct __kernel_timespec *ts,
+                    sigset_t *sigmask),
+                   (ring, cqe_ptr, wait_nr, ts, sigmask))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, __io_uring_get_cqe,
+                   (struct io_uring * ring, struct io_uring_cqe **cqe_ptr,
+                    unsigned submit, unsigned wait_nr, sigset_t *sigmask),
+                   (ring, cqe_ptr, submit, wait_nr, sigmask))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_wait_cqes,
+                   (struct io_uring * ring, struct io_uring_cqe **cqe_ptr,
+                    unsigned wait_nr, struct __kernel_timespec *ts,
+                    sigset_t *sigmask),
+                   (ring, cqe_ptr, wait_nr, ts, sigmask))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_wait_cqe_timeout,
+                   (struct io_uring * ring, struct io_uring_cqe **cqe_ptr,
+                    struct __kernel_timespec *ts),
+                   (ring, cqe_ptr, ts))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, unsigned,
+                   io_uring_peek_batch_cqe,
+                   (struct io_uring * ring, struct io_uring_cqe **cqes,
+                    unsigned count),
+                   (ring, cqes, count))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_enter,
+                   (unsigned int fd, unsigned int to_submit,
+                    unsigned int min_complete, unsigned int flags,
+                    sigset_t *sig),
+                   (fd, to_submit, min_complete, flags, sig))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_register_files,
+                   (struct io_uring * ring, const int *files,
+                    unsigned nr_files),
+                   (ring, files, nr_files))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, int, io_uring_unregister_files,
+                   (struct io_uring * ring), (ring))
+DFT_GOTCHA_WRAPPER(dftracer::IOUringFunction, void, io_uring_queue_exit,
+                   (struct io_uring * ring), (ring))
+
+static gotcha_binding_t io_uring_bindings[] = {
+    DFT_GOTCHA_BINDING(io_uring_submit),
+    DFT_GOTCHA_BINDING(io_uring_submit_and_wait),
+    DFT_GOTCHA_BINDING(io_uring_submit_and_wait_timeout),
+    DFT_GOTCHA_BINDING(__io_uring_get_cqe),
+    DFT_GOTCHA_BINDING(io_uring_wait_cqes),
+    DFT_GOTCHA_BINDING(io_uring_wait_cqe_timeout),
+    DFT_GOTCHA_BINDING(io_uring_peek_batch_cqe),
+    DFT_GOTCHA_BINDING(io_uring_enter),
+    DFT_GOTCHA_BINDING(io_uring_register_files),
+    DFT_GOTCHA_BINDING(io_uring_unregister_files),
+    DFT_GOTCHA_BINDING(io_uring_queue_exit),
+};
+
+void dftracer::IOUringFunction::initialize() {
+  DFTRACER_LOG_DEBUG("Initializing IOUringFunction instance", "");
+  auto conf =
+      dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  gotcha_set_priority("dftracer", conf->gotcha_priority);
+  auto status = gotcha_wrap(
+      io_uring_bindings, sizeof(io_uring_bindings) / sizeof(gotcha_binding_t),
+      "dftracer");
+  if (status != GOTCHA_SUCCESS) {
+    DFTRACER_LOG_WARN("IOUringFunction gotcha_wrap returned %d", status);
+  }
+}
+
+void dftracer::IOUringFunction::finalize() {
+  DFTRACER_LOG_DEBUG("Finalizing IOUringFunction instance", "");
+  stop_trace = true;
+  std::lock_guard<std::mutex> lock(mtx);
+  rings.clear();
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef DFTRACER_IO_URING_INTERCEPT_H
+#define DFTRACER_IO_URING_INTERCEPT_H
+
+#ifdef DFTRACER_DEBUG
+#include <dftracer/core/dftracer_config_dbg.hpp>
+#else
+#include <dftracer/core/dftracer_config.hpp>
+#endif
+#ifdef DFTRACER_IO_URING_TRACING_ENABLE
+
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/function/generic_function.h>
+#include <liburing.h>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dftracer {
+
+// Traces io_uring requests issued through liburing. SQEs the kernel consumed
+// are captured at submit and matched to CQEs by user_data when the
+// application reaps them.
+class IOUringFunction : public dftracer::GenericFunction {
+ private:
+  static bool stop_trace;
+  static const size_t MAX_PENDING = 1 << 16;
+
+  struct PendingIO {
+    TimeResolution submit_time;
+    HashType fhash;
+    uint8_t opcode;
+    uint32_t len;
+    uint64_t offset;
+    unsigned depth;
+  };
+  struct RingState {
+    std::unordered_map<uint64_t, std::deque<PendingIO>> pending;
+    std::vector<int> fixed_files;
+    size_t num_pending;
+    // CQ index up to which CQEs were matched; they stay in the ring until
+    // the application advances its head
+    unsigned cq_scanned;
+    RingState() : pending(), fixed_files(), num_pending(0), cq_scanned(0) {}
+  };
+
+  std::mutex mtx;
+  std::unordered_map<struct io_uring *, RingState> rings;
+
+  HashType get_hash(RingState &state, const struct io_uring_sqe *sqe);
+  unsigned queued_submissions(struct io_uring *ring,
+                              std::vector<struct io_uring_sqe> &sqes);
+  size_t capture_submissions(struct io_uring *ring,
+                             const std::vector<struct io_uring_sqe> &sqes,
+                             size_t consumed, TimeResolution submit_time);
+  void reap_completions(struct io_uring *ring);
+  void log_io(const PendingIO &io, int ret, TimeResolution end_time);
+  void log_submit(ConstEventNameType name, TimeResolution start_time,
+                  unsigned depth, size_t traced, int ret);
+
+ public:
+  IOUringFunction() : dftracer::GenericFunction(), mtx(), rings() {
+    DFTRACER_LOG_DEBUG("Creating IOUringFunction instance", "");
+  }
+
+  static std::shared_ptr<IOUringFunction> get_active_instance();
+
+  void initialize() override;
+  void finalize() override;
+
+  int io_uring_submit(struct io_uring *ring);
+  int io_uring_submit_and_wait(struct io_uring *ring, unsigned wait_nr);
+  int io_uring_submit_and_wait_timeout(struct io_uring *ring,
+                                       struct io_uring_cqe **cqe_ptr,
+                                       unsigned wait_nr,
+                                       struct __kernel_timespec *ts,
+                                       sigset_t *sigmask);
+  int __io_uring_get_cqe(struct io_uring *ring, struct io_uring_cqe **cqe_ptr,
+                         unsigned submit, unsigned wait_nr, sigset_t *sigmask);
+  int io_uring_wait_cqes(struct io_uring *ring, struct io_uring_cqe **cqe_ptr,
+                         unsigned wait_nr, struct __kernel_timespec *ts,
+                         sigset_t *sigmask);
+  int io_uring_wait_cqe_timeout(struct io_uring *ring,
+                                struct io_uring_cqe **cqe_ptr,
+                                struct __kernel_timespec *ts);
+  unsigned io_uring_peek_batch_cqe(struct io_uring *ring,
+                                   struct io_uring_cqe **cqes, unsigned count);
+  int io_uring_enter(unsigned int fd, unsigned int to_submit,
+                     unsigned int min_complete, unsigned int flags,
+                     sigset_t *sig);
+  int io_uring_register_files(struct io_uring *ring, const int *files,
+                              unsigned nr_files);
+  int io_uring_unregister_files(struct io_uring *ring);
+  void io_uring_queue_exit(struct io_uring *ring);
+};
+
+}  // namespace dftracer
+
+#endif
+#endif  // DFTRACER_IO_URING_INTERCEPT_H
@@ -0,0 +1,89 @@
+#include <dftracer/core/governor/overhead_governor.h>
+#include <dftracer/core/utils/configuration_manager.h>
+
+template <>
+std::shared_ptr<dftracer::OverheadGovernor>
+    dftracer::Singleton<dftracer::OverheadGovernor>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::OverheadGovernor>::stop_creating_instances =
+    false;
+
+namespace dftracer {
+OverheadGovernor::OverheadGovernor()
+    : max_events(100000),
+      max_overhead_ppm(50000),
+      window_us(1000000),
+      window_start(0),
+      peak_rate(0),
+      peak_overhead(0),
+      level(GovernorLevel::GOVERNOR_LEVEL_FULL),
+      calm_windows(0) {
+  DFTRACER_LOG_DEBUG("OverheadGovernor.OverheadGovernor", "");
+  auto config =
+      dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  if (config->governor_max_events > 0) {
+    max_events = config->governor_max_events;
+  }
+  if (config->governor_max_overhead > 0) {
+    max_overhead_ppm = (uint64_t)(config->governor_max_overhead * 10000);
+  }
+  if (config->trace_interval_ms > 0) {
+    window_us = config->trace_interval_ms * 1000;
+  }
+}
+
+bool OverheadGovernor::record(uint64_t begin_ns, uint64_t end_ns,
+                              GovernorTransition &transition) {
+  struct ThreadWindow {
+    TimeResolution start;
+    uint64_t events;
+    uint64_t busy_ns;
+  };
+  thread_local ThreadWindow local = {0, 0, 0};
+  TimeResolution now = end_ns / 1000;
+  if (local.start == 0) local.start = now;
+  local.events++;
+  local.busy_ns += end_ns - begin_ns;
+  TimeResolution elapsed = now - local.start;
+  if (elapsed < window_us) return false;
+  fetch_max(peak_rate, local.events * 1000000 / elapsed);
+  fetch_max(peak_overhead, local.busy_ns * 1000 / elapsed);
+  local = ThreadWindow{now, 0, 0};
+  return evaluate(now, transition);
+}
+
+bool OverheadGovernor::evaluate(TimeResolution now,
+                                GovernorTransition &transition) {
+  TimeResolution start = window_start.load();
+  if (start == 0) {
+    window_start.compare_exchange_strong(start, now);
+    return false;
+  }
+  if (now - start < window_us ||
+      !window_start.compare_exchange_strong(start, now)) {
+    return false;
+  }
+  uint64_t rate = peak_rate.exchange(0);
+  uint64_t overhead = peak_overhead.exchange(0);
+  int current = level.load();
+  int next = current;
+  if (rate > max_events || overhead > max_overhead_ppm) {
+    calm_windows = 0;
+    if (current < GovernorLevel::GOVERNOR_LEVEL_COUNTERS) next = current + 1;
+  } else if (rate * 2 < max_events && overhead * 2 < max_overhead_ppm) {
+    if (++calm_windows >= GOVERNOR_CALM_WINDOWS &&
+        current > GovernorLevel::GOVERNOR_LEVEL_FULL) {
+      next = current - 1;
+      calm_windows = 0;
+    }
+  } else {
+    calm_windows = 0;
+  }
+  if (next == current) return false;
+  level = next;
+  DFTRACER_LOG_INFO("OverheadGovernor level %d -> %d", current, next);
+  transition = GovernorTransition{(GovernorLevel)current, (GovernorLevel)next,
+                                  rate, overhead};
+  return true;
+}
+}  // namespace dftracer
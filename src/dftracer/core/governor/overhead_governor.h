@@ -0,0 +1,73 @@
+#ifndef DFTRACER_OVERHEAD_GOVERNOR_H
+#define DFTRACER_OVERHEAD_GOVERNOR_H
+#include <dftracer/core/common/enumeration.h>
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/common/typedef.h>
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace dftracer {
+struct GovernorTransition {
+  GovernorLevel from;
+  GovernorLevel to;
+  uint64_t events_per_sec;
+  // fraction of the thread's time spent in dftracer, in parts per million
+  uint64_t overhead_ppm;
+};
+
+/**
+ * Keeps tracing overhead within budget during event storms. Every thread
+ * measures its own event rate and the time it spends inside the logger over
+ * a trace interval and publishes the result. Once per interval the busiest
+ * thread's figures decide the process wide level: one step down when a
+ * budget was exceeded, one step up after GOVERNOR_CALM_WINDOWS intervals
+ * below half of both budgets.
+ */
+class OverheadGovernor {
+ private:
+  static const int GOVERNOR_CALM_WINDOWS = 3;
+  uint64_t max_events;
+  uint64_t max_overhead_ppm;
+  TimeResolution window_us;
+  std::atomic<TimeResolution> window_start;
+  std::atomic<uint64_t> peak_rate;
+  std::atomic<uint64_t> peak_overhead;
+  std::atomic<int> level;
+  std::atomic<int> calm_windows;
+
+  static inline void fetch_max(std::atomic<uint64_t> &target,
+                               uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed)) {
+    }
+  }
+
+  bool evaluate(TimeResolution now, GovernorTransition &transition);
+
+ public:
+  OverheadGovernor();
+
+  static inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  inline GovernorLevel get_level() const {
+    return (GovernorLevel)level.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Accounts one event that kept the calling thread busy between begin_ns
+   * and end_ns. Returns true when the caller must apply a level change.
+   */
+  bool record(uint64_t begin_ns, uint64_t end_ns,
+              GovernorTransition &transition);
+};
+}  // namespace dftracer
+#endif  // DFTRACER_OVERHEAD_GOVERNOR_H
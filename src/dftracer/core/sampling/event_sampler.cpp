@@ -0,0 +1,158 @@
+#include <dftracer/core/sampling/event_sampler.h>
+#include <dftracer/core/utils/posix_internal.h>
+#include <time.h>
+
+#include <cstring>
+
+template <>
+std::shared_ptr<dftracer::EventSampler>
+    dftracer::Singleton<dftracer::EventSampler>::instance = nullptr;
+template <>
+bool dftracer::Singleton<dftracer::EventSampler>::stop_creating_instances =
+    false;
+
+namespace dftracer {
+EventSampler::EventSampler() : threads_mtx(), threads(), interval_us(1000000) {
+  DFTRACER_LOG_DEBUG("EventSampler.EventSampler", "");
+  config = dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  if (config->trace_interval_ms > 0) {
+    interval_us = config->trace_interval_ms * 1000;
+  }
+}
+
+static uint64_t seed() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t rng = ((uint64_t)df_gettid() << 32) ^ (uint64_t)ts.tv_nsec ^
+                 ((uint64_t)ts.tv_sec << 16);
+  return rng == 0 ? 0x9E3779B97F4A7C15ULL : rng;
+}
+
+EventSampler::ThreadState *EventSampler::local_state() {
+  thread_local ThreadState *state = nullptr;
+  if (state == nullptr) {
+    auto created = std::make_shared<ThreadState>();
+    created->rng = seed();
+    created->last = nullptr;
+    std::lock_guard<std::mutex> lock(threads_mtx);
+    threads.push_back(created);
+    state = created.get();
+  }
+  return state;
+}
+
+EventSampler::CategoryState &EventSampler::get_state(
+    ThreadState *state, ConstEventNameType category) {
+  if (state->last != nullptr &&
+      strcmp(state->last->category.c_str(), category) == 0) {
+    return *state->last;
+  }
+  std::string key(category);
+  auto iter = state->categories.find(key);
+  if (iter == state->categories.end()) {
+    CategoryState created;
+    created.category = key;
+    created.rule = SamplingRule{SamplingType::SAMPLING_TYPE_NONE, 0};
+    auto rule = config->sampling.find(key);
+    if (rule != config->sampling.end()) created.rule = rule->second;
+    created.mark = 0;
+    created.seen = 0;
+    iter = state->categories.emplace(key, std::move(created)).first;
+  }
+  state->last = &iter->second;
+  return iter->second;
+}
+
+void EventSampler::drain(CategoryState &state,
+                         std::vector<SampledEvent> &ready) {
+  if (!state.reservoir.empty()) {
+    double weight = (double)state.seen / state.reservoir.size();
+    for (auto &event : state.reservoir) {
+      event.weight = weight;
+      ready.push_back(std::move(event));
+    }
+    state.reservoir.clear();
+  }
+  state.seen = 0;
+}
+
+bool EventSampler::offer(int index, ConstEventNameType event_name,
+                         ConstEventNameType category,
+                         TimeResolution start_time, TimeResolution duration,
+                         dftracer::Metadata *metadata, ThreadID tid,
+                         double &weight, std::vector<SampledEvent> &ready) {
+  ThreadState *thread_state = local_state();
+  std::lock_guard<std::mutex> lock(thread_state->mtx);
+  CategoryState &state = get_state(thread_state, category);
+  size_t value = state.rule.value;
+  switch (state.rule.type) {
+    case SamplingType::SAMPLING_TYPE_COUNT: {
+      if (next(thread_state->rng) % value != 0) break;
+      weight = (double)value;
+      return true;
+    }
+    case SamplingType::SAMPLING_TYPE_TIME: {
+      state.seen++;
+      if (start_time < state.mark) break;
+      weight = (double)state.seen;
+      state.seen = 0;
+      state.mark = start_time + next(thread_state->rng) % (2 * value);
+      return true;
+    }
+    case SamplingType::SAMPLING_TYPE_RESERVOIR: {
+      TimeResolution interval = start_time - start_time % interval_us;
+      if (state.seen > 0 && interval != state.mark) drain(state, ready);
+      state.mark = interval;
+      state.seen++;
+      size_t slot = state.reservoir.size();
+      if (slot >= value) {
+        slot = next(thread_state->rng) % state.seen;
+        if (slot >= value) break;
+        if (state.reservoir[slot].metadata != nullptr) {
+          delete state.reservoir[slot].metadata;
+        }
+      } else {
+        state.reservoir.emplace_back();
+      }
+      state.reservoir[slot] =
+          SampledEvent{index,      event_name, category, start_time,
+                       duration,   metadata,   tid,      0};
+      return false;
+    }
+    default: {
+      weight = 0;
+      return true;
+    }
+  }
+  if (metadata != nullptr) delete metadata;
+  return false;
+}
+
+void EventSampler::forked() {
+  new (&threads_mtx) std::mutex();
+  for (auto &thread_state : threads) {
+    new (&thread_state->mtx) std::mutex();
+    for (auto &entry : thread_state->categories) {
+      for (auto &event : entry.second.reservoir) {
+        if (event.metadata != nullptr) delete event.metadata;
+      }
+    }
+    thread_state->categories.clear();
+    thread_state->last = nullptr;
+    thread_state->rng = seed();
+  }
+}
+
+std::vector<SampledEvent> EventSampler::collect() {
+  DFTRACER_LOG_DEBUG("EventSampler.collect", "");
+  std::vector<SampledEvent> ready;
+  std::lock_guard<std::mutex> threads_lock(threads_mtx);
+  for (auto &thread_state : threads) {
+    std::lock_guard<std::mutex> lock(thread_state->mtx);
+    for (auto &entry : thread_state->categories) {
+      drain(entry.second, ready);
+    }
+  }
+  return ready;
+}
+}  // namespace dftracer
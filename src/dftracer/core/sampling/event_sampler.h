@@ -0,0 +1,96 @@
+#ifndef DFTRACER_EVENT_SAMPLER_H
+#define DFTRACER_EVENT_SAMPLER_H
+#include <dftracer/core/common/datastructure.h>
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/common/typedef.h>
+#include <dftracer/core/utils/configuration_manager.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dftracer {
+// event held back by a reservoir, names are copied as the caller's strings
+// may not outlive the call
+struct SampledEvent {
+  int index;
+  std::string name;
+  std::string category;
+  TimeResolution start_time;
+  TimeResolution duration;
+  dftracer::Metadata *metadata;
+  ThreadID tid;
+  double weight;
+};
+
+/**
+ * Per category event sampling. Every thread keeps its own PRNG and sampling
+ * state so that decisions never touch shared state. Kept events carry the
+ * number of events they stand for as weight:
+ *   COUNT     keeps each event with probability 1/value, weight value.
+ *   TIME      keeps one event after a random gap averaging value us, weight
+ *             the number of events seen since the previous kept one.
+ *   RESERVOIR keeps value uniformly chosen events per trace interval, weight
+ *             events seen / events kept in that interval. The reservoir is
+ *             written when the thread enters the next interval or at finalize.
+ */
+class EventSampler {
+ private:
+  struct CategoryState {
+    std::string category;
+    SamplingRule rule;
+    // TIME: next time an event is kept, RESERVOIR: current interval
+    TimeResolution mark;
+    uint64_t seen;
+    std::vector<SampledEvent> reservoir;
+  };
+  struct ThreadState {
+    std::mutex mtx;
+    uint64_t rng;
+    CategoryState *last;
+    std::unordered_map<std::string, CategoryState> categories;
+  };
+  std::shared_ptr<dftracer::ConfigurationManager> config;
+  std::mutex threads_mtx;
+  std::vector<std::shared_ptr<ThreadState>> threads;
+  TimeResolution interval_us;
+
+  ThreadState *local_state();
+  CategoryState &get_state(ThreadState *state, ConstEventNameType category);
+  void drain(CategoryState &state, std::vector<SampledEvent> &ready);
+
+  // xorshift64*
+  static inline uint64_t next(uint64_t &rng) {
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return rng * 0x2545F4914F6CDD1DULL;
+  }
+
+ public:
+  EventSampler();
+
+  /**
+   * Decides on an event. Returns true when it is to be written now with the
+   * given weight (0 if its category is not sampled). Otherwise the sampler
+   * has taken ownership of metadata. Reservoirs closed by this event are
+   * appended to ready.
+   */
+  bool offer(int index, ConstEventNameType event_name,
+             ConstEventNameType category, TimeResolution start_time,
+             TimeResolution duration, dftracer::Metadata *metadata,
+             ThreadID tid, double &weight, std::vector<SampledEvent> &ready);
+
+  // drains the reservoirs of all threads
+  std::vector<SampledEvent> collect();
+
+  // in a forked child: drops the parent's reservoirs and reseeds so that
+  // parent and child do not sample the same events, see FileCounters
+  void forked();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_EVENT_SAMPLER_H
@@ -0,0 +1,91 @@
+#include <dftracer/core/utils/config_snapshot.h>
+//
+#include <dftracer/core/common/constants.h>
+#include <sys/stat.h>
+
+#include <cstring>
+
+extern char **environ;
+
+namespace dftracer {
+static const char HEX[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static uint64_t fnv1a(const char *data, size_t len,
+                      uint64_t hash = 1469598103934665603ULL) {
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= (unsigned char)data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static uint64_t file_fingerprint(const char *path) {
+  struct stat st;
+  if (path == nullptr || path[0] == '\0' || stat(path, &st) != 0) return 0;
+  uint64_t fields[4] = {(uint64_t)st.st_ino, (uint64_t)st.st_size,
+                        (uint64_t)st.st_mtim.tv_sec,
+                        (uint64_t)st.st_mtim.tv_nsec};
+  return fnv1a(reinterpret_cast<const char *>(fields), sizeof(fields));
+}
+
+std::string SnapshotWriter::encode() const {
+  std::string hex(data_.size() * 2, '0');
+  for (size_t i = 0; i < data_.size(); ++i) {
+    unsigned char c = data_[i];
+    hex[2 * i] = HEX[c >> 4];
+    hex[2 * i + 1] = HEX[c & 0xf];
+  }
+  return hex;
+}
+
+bool SnapshotReader::decode(const char *value) {
+  size_t len = strlen(value);
+  if (len % 2 != 0) return false;
+  data_.resize(len / 2);
+  for (size_t i = 0; i < data_.size(); ++i) {
+    int high = hex_value(value[2 * i]);
+    int low = hex_value(value[2 * i + 1]);
+    if (high < 0 || low < 0) return false;
+    data_[i] = (char)((high << 4) | low);
+  }
+  pos_ = 0;
+  return true;
+}
+
+bool SnapshotReader::field(std::string &value) {
+  uint32_t len = 0;
+  if (!field(len) || pos_ + len > data_.size()) return false;
+  value.assign(data_.data() + pos_, len);
+  pos_ += len;
+  return true;
+}
+
+// the variables are combined independent of their order in environ, which
+// exec wrappers may change
+uint64_t config_fingerprint(const char *conf_file,
+                            const std::string &aggregation_file) {
+  static const size_t snapshot_len = strlen(DFTRACER_CONFIG_SNAPSHOT);
+  static const size_t context_len = strlen(DFTRACER_PARENT_CONTEXT);
+  uint64_t variables = 0;
+  for (char **env = environ; env != nullptr && *env != nullptr; ++env) {
+    const char *entry = *env;
+    if (strncmp(entry, "DFTRACER_", 9) != 0) continue;
+    if ((strncmp(entry, DFTRACER_CONFIG_SNAPSHOT, snapshot_len) == 0 &&
+         entry[snapshot_len] == '=') ||
+        (strncmp(entry, DFTRACER_PARENT_CONTEXT, context_len) == 0 &&
+         entry[context_len] == '=')) {
+      continue;
+    }
+    variables += fnv1a(entry, strlen(entry));
+  }
+  uint64_t fields[3] = {variables, file_fingerprint(conf_file),
+                        file_fingerprint(aggregation_file.c_str())};
+  return fnv1a(reinterpret_cast<const char *>(fields), sizeof(fields));
+}
+}  // namespace dftracer
@@ -0,0 +1,114 @@
+#ifndef DFTRACER_CONFIG_SNAPSHOT_H
+#define DFTRACER_CONFIG_SNAPSHOT_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace dftracer {
+#define DFT_CONFIG_SNAPSHOT_MAGIC 0x44465443u  // "DFTC"
+#define DFT_CONFIG_SNAPSHOT_VERSION 1
+// encoded size above which no snapshot is published; a single environment
+// string may not exceed MAX_ARG_STRLEN (32 pages) and the environment also
+// counts against ARG_MAX of every exec
+#define DFT_CONFIG_SNAPSHOT_MAX_SIZE (16 * 1024)
+
+/**
+ * Binary form of a parsed ConfigurationManager. The first process that
+ * parses the YAML file and environment publishes it hex encoded in
+ * DFTRACER_CONFIG_SNAPSHOT, so processes started by exec load it instead
+ * of parsing again. A snapshot carries a fingerprint of its inputs, every
+ * DFTRACER_* variable and the size and time of the YAML and aggregation
+ * files; a descendant whose inputs differ parses from scratch.
+ *
+ * Writer and reader share the field() interface so one list of fields
+ * describes both directions, see ConfigurationManager::snapshot_fields.
+ */
+class SnapshotWriter {
+ public:
+  SnapshotWriter() : data_() {}
+  template <typename T>
+  bool field(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values are copied");
+    data_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    return true;
+  }
+  bool field(const std::string &value) {
+    field<uint32_t>(value.size());
+    data_.append(value);
+    return true;
+  }
+  bool field(const std::vector<std::string> &values) {
+    field<uint32_t>(values.size());
+    for (const auto &value : values) field(value);
+    return true;
+  }
+  template <typename T>
+  bool field(const std::unordered_map<std::string, T> &values) {
+    field<uint32_t>(values.size());
+    for (const auto &value : values) {
+      field(value.first);
+      field(value.second);
+    }
+    return true;
+  }
+  // hex, as environment values cannot hold NUL bytes
+  std::string encode() const;
+
+ private:
+  std::string data_;
+};
+
+class SnapshotReader {
+ public:
+  SnapshotReader() : data_(), pos_(0) {}
+  // false if value is not valid hex
+  bool decode(const char *value);
+  template <typename T>
+  bool field(T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values are copied");
+    if (pos_ + sizeof(T) > data_.size()) return false;
+    memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+  bool field(std::string &value);
+  bool field(std::vector<std::string> &values) {
+    uint32_t size = 0;
+    if (!field(size)) return false;
+    values.assign(size, std::string());
+    for (auto &value : values) {
+      if (!field(value)) return false;
+    }
+    return true;
+  }
+  template <typename T>
+  bool field(std::unordered_map<std::string, T> &values) {
+    uint32_t size = 0;
+    if (!field(size)) return false;
+    values.clear();
+    for (uint32_t i = 0; i < size; ++i) {
+      std::string key;
+      T value;
+      if (!field(key) || !field(value)) return false;
+      values.insert_or_assign(key, value);
+    }
+    return true;
+  }
+  bool done() const { return pos_ == data_.size(); }
+
+ private:
+  std::string data_;
+  size_t pos_;
+};
+
+// fingerprint of everything a ConfigurationManager is parsed from
+uint64_t config_fingerprint(const char *conf_file,
+                            const std::string &aggregation_file);
+}  // namespace dftracer
+#endif  // DFTRACER_CONFIG_SNAPSHOT_H
@@ -5,6 +5,7 @@
 #include "configuration_manager.h"
 
 #include <dftracer/core/common/constants.h>
+#include <dftracer/core/utils/config_snapshot.h>
 #include <yaml-cpp/yaml.h>
 
 #include <filesystem>
@@ -20,6 +21,13 @@
 #define DFT_YAML_TRACER_LOG_LEVEL "log_level"
 #define DFT_YAML_TRACER_COMPRESSION "compression"
 #define DFT_YAML_TRACER_INTERVAL "interval"
+#define DFT_YAML_TRACER_ROTATE_SIZE "rotate_size_mb"
+#define DFT_YAML_TRACER_ROTATE_MINUTES "rotate_minutes"
+#define DFT_YAML_TRACER_STAGE_DIR "stage_dir"
+#define DFT_YAML_TRACER_STAGE_DRAIN "stage_drain_mbps"
+#define DFT_YAML_TRACER_WRITER_BACKEND "writer_backend"
+#define DFT_YAML_TRACER_SHM_RING "shm_ring_mb"
+#define DFT_YAML_TRACER_MPI_SHARED_FILE "mpi_shared_file"
 // GOTCHA
 #define DFT_YAML_GOTCHA "gotcha"
 #define DFT_YAML_GOTCHA_PRIORITY "priority"
@@ -38,12 +46,34 @@
 #define DFT_YAML_FEATURES_AGGREGATION_FILE "file"
 #define DFT_YAML_FEATURES_AGGREGATION_INCLUSION_FILTERS "inclusion"
 #define DFT_YAML_FEATURES_AGGREGATION_EXCLUSION_FILTERS "exclusion"
+#define DFT_YAML_FEATURES_PAGE_CACHE "page_cache"
+#define DFT_YAML_FEATURES_PAGE_CACHE_ENABLE "enable"
+#define DFT_YAML_FEATURES_PAGE_CACHE_BUDGET "budget"
+#define DFT_YAML_FEATURES_ACCESS_PATTERN "access_pattern"
+#define DFT_YAML_FEATURES_COUNTERS "counters"
+#define DFT_YAML_FEATURES_MIN_DURATION "min_duration"
+#define DFT_YAML_FEATURES_SAMPLING "sampling"
+#define DFT_YAML_FEATURES_SAMPLING_TYPE "type"
+#define DFT_YAML_FEATURES_SAMPLING_VALUE "value"
+#define DFT_YAML_FEATURES_GOVERNOR "governor"
+#define DFT_YAML_FEATURES_GOVERNOR_ENABLE "enable"
+#define DFT_YAML_FEATURES_GOVERNOR_MAX_EVENTS "max_events"
+#define DFT_YAML_FEATURES_GOVERNOR_MAX_OVERHEAD "max_overhead"
+#define DFT_YAML_FEATURES_COALESCE "coalesce"
+#define DFT_YAML_FEATURES_COALESCE_ENABLE "enable"
+#define DFT_YAML_FEATURES_COALESCE_GAP "gap_us"
+#define DFT_YAML_FEATURES_FLIGHT_RECORDER "flight_recorder"
+#define DFT_YAML_FEATURES_FLIGHT_RECORDER_ENABLE "enable"
+#define DFT_YAML_FEATURES_FLIGHT_RECORDER_SIZE "size_mb"
+#define DFT_YAML_FEATURES_FLIGHT_RECORDER_TRIGGER "trigger_us"
 
 // INTERNAL
 #define DFT_YAML_INTERNAL "internal"
 #define DFT_YAML_INTERNAL_SIGNALS "bind_signals"
 #define DFT_YAML_INTERNAL_THROW_ERROR "throw_error"
 #define DFT_YAML_INTERNAL_WRITE_BUFFER_SIZE "write_buffer_size"
+#define DFT_YAML_INTERNAL_MMAP_BUFFER "mmap_buffer"
+#define DFT_YAML_INTERNAL_FLUSH_INTERVAL "flush_interval_ms"
 template <>
 std::shared_ptr<dftracer::ConfigurationManager>
     dftracer::Singleton<dftracer::ConfigurationManager>::instance = nullptr;
@@ -68,12 +98,41 @@ dftracer::ConfigurationManager::ConfigurationManager()
       bind_signals(false),
       throw_error(false),
       write_buffer_size(16 * 1024 * 1024),
+      mmap_buffer(false),
+      flush_interval_ms(0),
+      rotate_size(0),
+      rotate_minutes(0),
+      stage_dir(),
+      stage_drain_bandwidth(0),
+      writer_backend(WriterBackendType::WRITER_BACKEND_STDIO),
+      shm_ring_size(8 * 1024 * 1024),
+      mpi_shared_file(false),
       trace_interval_ms(1000),
+      page_cache_sampling(false),
+      page_cache_budget(64 * 1024),
+      access_pattern(false),
+      counters(false),
+      min_duration(),
+      sampling(),
+      governor(false),
+      governor_max_events(100000),
+      governor_max_overhead(5.0),
+      coalesce(false),
+      coalesce_gap_us(1000),
+      flight_recorder(false),
+      flight_recorder_size(64 * 1024 * 1024),
+      flight_recorder_trigger_us(0),
       aggregation_enable(false),
       aggregation_type(AggregationType::AGGREGATION_TYPE_FULL),
       aggregation_inclusion_rules(),
-      aggregation_exclusion_rules() {
+      aggregation_exclusion_rules(),
+      from_snapshot(false) {
   const char *env_conf = getenv(DFTRACER_CONFIGURATION);
+  if (load_snapshot(env_conf)) {
+    DFTRACER_LOGGER_LEVEL(logger_level);
+    DFTRACER_LOG_DEBUG("ConfigurationManager loaded from snapshot", "");
+    return;
+  }
   YAML::Node config;
   if (env_conf != nullptr) {
     config = YAML::LoadFile(env_conf);
@@ -134,6 +193,54 @@ dftracer::ConfigurationManager::ConfigurationManager()
       }
       DFTRACER_LOG_DEBUG("YAML ConfigurationManager.compression %d",
                          this->compression);
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_ROTATE_SIZE]) {
+        this->rotate_size =
+            config[DFT_YAML_TRACER][DFT_YAML_TRACER_ROTATE_SIZE].as<size_t>() *
+            1024 * 1024;
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.rotate_size %d",
+                         this->rotate_size);
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_ROTATE_MINUTES]) {
+        this->rotate_minutes =
+            config[DFT_YAML_TRACER][DFT_YAML_TRACER_ROTATE_MINUTES]
+                .as<size_t>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.rotate_minutes %d",
+                         this->rotate_minutes);
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_STAGE_DIR]) {
+        this->stage_dir = config[DFT_YAML_TRACER][DFT_YAML_TRACER_STAGE_DIR]
+                              .as<std::string>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.stage_dir %s",
+                         this->stage_dir.c_str());
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_STAGE_DRAIN]) {
+        this->stage_drain_bandwidth =
+            config[DFT_YAML_TRACER][DFT_YAML_TRACER_STAGE_DRAIN].as<size_t>() *
+            1024 * 1024;
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.stage_drain_bandwidth %d",
+                         this->stage_drain_bandwidth);
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_WRITER_BACKEND]) {
+        convert(config[DFT_YAML_TRACER][DFT_YAML_TRACER_WRITER_BACKEND]
+                    .as<std::string>(),
+                this->writer_backend);
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.writer_backend %s",
+                         to_string(this->writer_backend).c_str());
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_SHM_RING]) {
+        this->shm_ring_size =
+            config[DFT_YAML_TRACER][DFT_YAML_TRACER_SHM_RING].as<size_t>() *
+            1024 * 1024;
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.shm_ring_size %d",
+                         this->shm_ring_size);
+      if (config[DFT_YAML_TRACER][DFT_YAML_TRACER_MPI_SHARED_FILE]) {
+        this->mpi_shared_file =
+            config[DFT_YAML_TRACER][DFT_YAML_TRACER_MPI_SHARED_FILE]
+                .as<bool>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.mpi_shared_file %d",
+                         this->mpi_shared_file);
     }
     if (config[DFT_YAML_GOTCHA]) {
       if (config[DFT_YAML_GOTCHA][DFT_YAML_GOTCHA_PRIORITY]) {
@@ -226,6 +333,137 @@ dftracer::ConfigurationManager::ConfigurationManager()
                          this->aggregation_type);
       DFTRACER_LOG_DEBUG("YAML ConfigurationManager.aggregation_enable %d",
                          this->aggregation_file);
+      if (config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_PAGE_CACHE]) {
+        if (config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_PAGE_CACHE]
+                  [DFT_YAML_FEATURES_PAGE_CACHE_ENABLE]) {
+          this->page_cache_sampling =
+              config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_PAGE_CACHE]
+                    [DFT_YAML_FEATURES_PAGE_CACHE_ENABLE]
+                        .as<bool>();
+        }
+        if (config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_PAGE_CACHE]
+                  [DFT_YAML_FEATURES_PAGE_CACHE_BUDGET]) {
+          this->page_cache_budget =
+              config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_PAGE_CACHE]
+                    [DFT_YAML_FEATURES_PAGE_CACHE_BUDGET]
+                        .as<size_t>();
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.page_cache_sampling %d",
+                         this->page_cache_sampling);
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.page_cache_budget %d",
+                         this->page_cache_budget);
+      if (config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_ACCESS_PATTERN]) {
+        this->access_pattern =
+            config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_ACCESS_PATTERN]
+                .as<bool>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.access_pattern %d",
+                         this->access_pattern);
+      if (config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_COUNTERS]) {
+        this->counters =
+            config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_COUNTERS].as<bool>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.counters %d",
+                         this->counters);
+      const auto &min_duration_node =
+          config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_MIN_DURATION];
+      if (min_duration_node && min_duration_node.IsMap()) {
+        for (const auto &item : min_duration_node) {
+          this->min_duration.insert_or_assign(item.first.as<std::string>(),
+                                              item.second.as<size_t>());
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.min_duration %d",
+                         this->min_duration.size());
+      const auto &sampling_node =
+          config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_SAMPLING];
+      if (sampling_node && sampling_node.IsMap()) {
+        for (const auto &item : sampling_node) {
+          SamplingRule rule{SamplingType::SAMPLING_TYPE_NONE, 0};
+          if (item.second[DFT_YAML_FEATURES_SAMPLING_TYPE]) {
+            convert(item.second[DFT_YAML_FEATURES_SAMPLING_TYPE]
+                        .as<std::string>(),
+                    rule.type);
+          }
+          if (item.second[DFT_YAML_FEATURES_SAMPLING_VALUE]) {
+            rule.value =
+                item.second[DFT_YAML_FEATURES_SAMPLING_VALUE].as<size_t>();
+          }
+          if (rule.type != SamplingType::SAMPLING_TYPE_NONE && rule.value > 0) {
+            this->sampling.insert_or_assign(item.first.as<std::string>(),
+                                            rule);
+          }
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.sampling %d",
+                         this->sampling.size());
+      const auto &governor_node =
+          config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_GOVERNOR];
+      if (governor_node) {
+        if (governor_node[DFT_YAML_FEATURES_GOVERNOR_ENABLE]) {
+          this->governor =
+              governor_node[DFT_YAML_FEATURES_GOVERNOR_ENABLE].as<bool>();
+        }
+        if (governor_node[DFT_YAML_FEATURES_GOVERNOR_MAX_EVENTS]) {
+          this->governor_max_events =
+              governor_node[DFT_YAML_FEATURES_GOVERNOR_MAX_EVENTS]
+                  .as<size_t>();
+        }
+        if (governor_node[DFT_YAML_FEATURES_GOVERNOR_MAX_OVERHEAD]) {
+          this->governor_max_overhead =
+              governor_node[DFT_YAML_FEATURES_GOVERNOR_MAX_OVERHEAD]
+                  .as<double>();
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.governor %d",
+                         this->governor);
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.governor_max_events %d",
+                         this->governor_max_events);
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.governor_max_overhead %f",
+                         this->governor_max_overhead);
+      const auto &coalesce_node =
+          config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_COALESCE];
+      if (coalesce_node) {
+        if (coalesce_node[DFT_YAML_FEATURES_COALESCE_ENABLE]) {
+          this->coalesce =
+              coalesce_node[DFT_YAML_FEATURES_COALESCE_ENABLE].as<bool>();
+        }
+        if (coalesce_node[DFT_YAML_FEATURES_COALESCE_GAP]) {
+          this->coalesce_gap_us =
+              coalesce_node[DFT_YAML_FEATURES_COALESCE_GAP].as<size_t>();
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.coalesce %d",
+                         this->coalesce);
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.coalesce_gap_us %d",
+                         this->coalesce_gap_us);
+      const auto &flight_node =
+          config[DFT_YAML_FEATURES][DFT_YAML_FEATURES_FLIGHT_RECORDER];
+      if (flight_node) {
+        if (flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_ENABLE]) {
+          this->flight_recorder =
+              flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_ENABLE].as<bool>();
+        }
+        if (flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_SIZE]) {
+          this->flight_recorder_size =
+              flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_SIZE]
+                  .as<size_t>() *
+              1024 * 1024;
+        }
+        if (flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_TRIGGER]) {
+          this->flight_recorder_trigger_us =
+              flight_node[DFT_YAML_FEATURES_FLIGHT_RECORDER_TRIGGER]
+                  .as<size_t>();
+        }
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.flight_recorder %d",
+                         this->flight_recorder);
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.flight_recorder_size %d",
+                         this->flight_recorder_size);
+      DFTRACER_LOG_DEBUG(
+          "YAML ConfigurationManager.flight_recorder_trigger_us %d",
+          this->flight_recorder_trigger_us);
     }
     if (config[DFT_YAML_INTERNAL]) {
       if (config[DFT_YAML_INTERNAL][DFT_YAML_INTERNAL_SIGNALS]) {
@@ -247,6 +485,19 @@ dftracer::ConfigurationManager::ConfigurationManager()
       }
       DFTRACER_LOG_DEBUG("YAML ConfigurationManager.write_buffer_size %d",
                          this->write_buffer_size);
+      if (config[DFT_YAML_INTERNAL][DFT_YAML_INTERNAL_MMAP_BUFFER]) {
+        this->mmap_buffer =
+            config[DFT_YAML_INTERNAL][DFT_YAML_INTERNAL_MMAP_BUFFER].as<bool>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.mmap_buffer %d",
+                         this->mmap_buffer);
+      if (config[DFT_YAML_INTERNAL][DFT_YAML_INTERNAL_FLUSH_INTERVAL]) {
+        this->flush_interval_ms =
+            config[DFT_YAML_INTERNAL][DFT_YAML_INTERNAL_FLUSH_INTERVAL]
+                .as<size_t>();
+      }
+      DFTRACER_LOG_DEBUG("YAML ConfigurationManager.flush_interval_ms %d",
+                         this->flush_interval_ms);
     }
   }
   const char *env_enable = getenv(DFTRACER_ENABLE);
@@ -378,11 +629,239 @@ dftracer::ConfigurationManager::ConfigurationManager()
     }
     DFTRACER_LOG_DEBUG("ENV ConfigurationManager.write_buffer_size %d",
                        this->write_buffer_size);
+    const char *env_mmap_buffer = getenv(DFTRACER_MMAP_BUFFER);
+    if (env_mmap_buffer != nullptr) {
+      this->mmap_buffer = strcmp(env_mmap_buffer, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.mmap_buffer %d",
+                       this->mmap_buffer);
+    const char *env_flush_interval = getenv(DFTRACER_FLUSH_INTERVAL_MS);
+    if (env_flush_interval != nullptr) {
+      this->flush_interval_ms = atol(env_flush_interval);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.flush_interval_ms %d",
+                       this->flush_interval_ms);
+    const char *env_rotate_size = getenv(DFTRACER_ROTATE_SIZE_MB);
+    if (env_rotate_size != nullptr) {
+      this->rotate_size = atol(env_rotate_size) * 1024 * 1024;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.rotate_size %d",
+                       this->rotate_size);
+    const char *env_rotate_minutes = getenv(DFTRACER_ROTATE_MINUTES);
+    if (env_rotate_minutes != nullptr) {
+      this->rotate_minutes = atol(env_rotate_minutes);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.rotate_minutes %d",
+                       this->rotate_minutes);
+    const char *env_stage_dir = getenv(DFTRACER_STAGE_DIR);
+    if (env_stage_dir != nullptr) {
+      this->stage_dir = env_stage_dir;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.stage_dir %s",
+                       this->stage_dir.c_str());
+    const char *env_stage_drain = getenv(DFTRACER_STAGE_DRAIN_MBPS);
+    if (env_stage_drain != nullptr) {
+      this->stage_drain_bandwidth = atol(env_stage_drain) * 1024 * 1024;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.stage_drain_bandwidth %d",
+                       this->stage_drain_bandwidth);
+    const char *env_writer_backend = getenv(DFTRACER_WRITER_BACKEND);
+    if (env_writer_backend != nullptr) {
+      convert(env_writer_backend, this->writer_backend);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.writer_backend %s",
+                       to_string(this->writer_backend).c_str());
+    const char *env_shm_ring = getenv(DFTRACER_SHM_RING_MB);
+    if (env_shm_ring != nullptr) {
+      this->shm_ring_size = atol(env_shm_ring) * 1024 * 1024;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.shm_ring_size %d",
+                       this->shm_ring_size);
+    const char *env_mpi_shared = getenv(DFTRACER_MPI_SHARED_FILE);
+    if (env_mpi_shared != nullptr) {
+      this->mpi_shared_file = strcmp(env_mpi_shared, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.mpi_shared_file %d",
+                       this->mpi_shared_file);
+    const char *env_page_cache = getenv(DFTRACER_PAGE_CACHE_SAMPLING);
+    if (env_page_cache != nullptr) {
+      this->page_cache_sampling = strcmp(env_page_cache, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.page_cache_sampling %d",
+                       this->page_cache_sampling);
+    const char *env_page_cache_budget = getenv(DFTRACER_PAGE_CACHE_BUDGET);
+    if (env_page_cache_budget != nullptr) {
+      this->page_cache_budget = atoi(env_page_cache_budget);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.page_cache_budget %d",
+                       this->page_cache_budget);
+    const char *env_access_pattern = getenv(DFTRACER_ACCESS_PATTERN);
+    if (env_access_pattern != nullptr) {
+      this->access_pattern = strcmp(env_access_pattern, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.access_pattern %d",
+                       this->access_pattern);
+    const char *env_counters = getenv(DFTRACER_COUNTERS);
+    if (env_counters != nullptr) {
+      this->counters = strcmp(env_counters, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.counters %d", this->counters);
+    const char *env_min_duration = getenv(DFTRACER_MIN_DURATION);
+    if (env_min_duration != nullptr) {
+      // comma separated name=us pairs, e.g. lseek=1,fstat=1,STDIO=2
+      for (const auto &rule : split(env_min_duration, ',')) {
+        auto pos = rule.find('=');
+        if (pos == std::string::npos || pos == 0) continue;
+        this->min_duration.insert_or_assign(
+            rule.substr(0, pos), strtoull(rule.c_str() + pos + 1, NULL, 10));
+      }
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.min_duration %d",
+                       this->min_duration.size());
+    const char *env_sampling = getenv(DFTRACER_SAMPLING);
+    if (env_sampling != nullptr) {
+      // comma separated category=TYPE:value, e.g. POSIX=COUNT:10
+      for (const auto &item : split(env_sampling, ',')) {
+        auto eq = item.find('=');
+        auto colon = item.find(':', eq);
+        if (eq == std::string::npos || eq == 0 || colon == std::string::npos)
+          continue;
+        SamplingRule rule{SamplingType::SAMPLING_TYPE_NONE, 0};
+        convert(item.substr(eq + 1, colon - eq - 1), rule.type);
+        rule.value = strtoull(item.c_str() + colon + 1, NULL, 10);
+        if (rule.type != SamplingType::SAMPLING_TYPE_NONE && rule.value > 0) {
+          this->sampling.insert_or_assign(item.substr(0, eq), rule);
+        }
+      }
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.sampling %d",
+                       this->sampling.size());
+    const char *env_governor = getenv(DFTRACER_GOVERNOR);
+    if (env_governor != nullptr) {
+      this->governor = strcmp(env_governor, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.governor %d", this->governor);
+    const char *env_governor_max_events = getenv(DFTRACER_GOVERNOR_MAX_EVENTS);
+    if (env_governor_max_events != nullptr) {
+      this->governor_max_events = atol(env_governor_max_events);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.governor_max_events %d",
+                       this->governor_max_events);
+    const char *env_governor_max_overhead =
+        getenv(DFTRACER_GOVERNOR_MAX_OVERHEAD);
+    if (env_governor_max_overhead != nullptr) {
+      this->governor_max_overhead = atof(env_governor_max_overhead);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.governor_max_overhead %f",
+                       this->governor_max_overhead);
+    const char *env_coalesce = getenv(DFTRACER_COALESCE);
+    if (env_coalesce != nullptr) {
+      this->coalesce = strcmp(env_coalesce, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.coalesce %d", this->coalesce);
+    const char *env_coalesce_gap = getenv(DFTRACER_COALESCE_GAP_US);
+    if (env_coalesce_gap != nullptr) {
+      this->coalesce_gap_us = atol(env_coalesce_gap);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.coalesce_gap_us %d",
+                       this->coalesce_gap_us);
+    const char *env_flight = getenv(DFTRACER_FLIGHT_RECORDER);
+    if (env_flight != nullptr) {
+      this->flight_recorder = strcmp(env_flight, "1") == 0;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.flight_recorder %d",
+                       this->flight_recorder);
+    const char *env_flight_size = getenv(DFTRACER_FLIGHT_SIZE_MB);
+    if (env_flight_size != nullptr) {
+      this->flight_recorder_size = atol(env_flight_size) * 1024 * 1024;
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.flight_recorder_size %d",
+                       this->flight_recorder_size);
+    const char *env_flight_trigger = getenv(DFTRACER_FLIGHT_TRIGGER_US);
+    if (env_flight_trigger != nullptr) {
+      this->flight_recorder_trigger_us = atol(env_flight_trigger);
+    }
+    DFTRACER_LOG_DEBUG("ENV ConfigurationManager.flight_recorder_trigger_us %d",
+                       this->flight_recorder_trigger_us);
   }
   derive_configurations();
+  if (this->enable) publish_snapshot(env_conf);
   DFTRACER_LOG_DEBUG("ENV ConfigurationManager finished", "");
 }
 
+// every member, in the same order for writing and reading
+template <typename Archive>
+bool dftracer::ConfigurationManager::snapshot_fields(Archive &archive) {
+  return archive.field(enable) && archive.field(init_type) &&
+         archive.field(log_file) && archive.field(data_dirs) &&
+         archive.field(metadata) && archive.field(core_affinity) &&
+         archive.field(gotcha_priority) && archive.field(logger_level) &&
+         archive.field(io) && archive.field(posix) && archive.field(stdio) &&
+         archive.field(compression) && archive.field(trace_all_files) &&
+         archive.field(tids) && archive.field(bind_signals) &&
+         archive.field(throw_error) && archive.field(write_buffer_size) &&
+         archive.field(mmap_buffer) && archive.field(flush_interval_ms) &&
+         archive.field(rotate_size) && archive.field(rotate_minutes) &&
+         archive.field(stage_dir) && archive.field(stage_drain_bandwidth) &&
+         archive.field(writer_backend) && archive.field(shm_ring_size) &&
+         archive.field(mpi_shared_file) && archive.field(trace_interval_ms) &&
+         archive.field(page_cache_sampling) &&
+         archive.field(page_cache_budget) && archive.field(access_pattern) &&
+         archive.field(counters) && archive.field(min_duration) &&
+         archive.field(sampling) && archive.field(governor) &&
+         archive.field(governor_max_events) &&
+         archive.field(governor_max_overhead) && archive.field(coalesce) &&
+         archive.field(coalesce_gap_us) && archive.field(flight_recorder) &&
+         archive.field(flight_recorder_size) &&
+         archive.field(flight_recorder_trigger_us) &&
+         archive.field(aggregation_enable) &&
+         archive.field(aggregation_type) && archive.field(aggregation_file) &&
+         archive.field(aggregation_inclusion_rules) &&
+         archive.field(aggregation_exclusion_rules);
+}
+
+bool dftracer::ConfigurationManager::load_snapshot(const char *conf_file) {
+  const char *env_snapshot = getenv(DFTRACER_CONFIG_SNAPSHOT);
+  if (env_snapshot == nullptr) return false;
+  SnapshotReader reader;
+  uint32_t magic = 0, version = 0, size = 0;
+  uint64_t fingerprint = 0;
+  if (!reader.decode(env_snapshot) || !reader.field(magic) ||
+      !reader.field(version) || !reader.field(size) ||
+      !reader.field(fingerprint) || magic != DFT_CONFIG_SNAPSHOT_MAGIC ||
+      version != DFT_CONFIG_SNAPSHOT_VERSION ||
+      size != sizeof(ConfigurationManager)) {
+    return false;
+  }
+  // parsed into a copy so that a stale snapshot leaves the defaults intact
+  ConfigurationManager loaded(*this);
+  if (!loaded.snapshot_fields(reader) || !reader.done() ||
+      fingerprint != config_fingerprint(conf_file, loaded.aggregation_file)) {
+    return false;
+  }
+  *this = std::move(loaded);
+  from_snapshot = true;
+  return true;
+}
+
+void dftracer::ConfigurationManager::publish_snapshot(const char *conf_file) {
+  SnapshotWriter writer;
+  writer.field<uint32_t>(DFT_CONFIG_SNAPSHOT_MAGIC);
+  writer.field<uint32_t>(DFT_CONFIG_SNAPSHOT_VERSION);
+  writer.field<uint32_t>(sizeof(ConfigurationManager));
+  writer.field(config_fingerprint(conf_file, aggregation_file));
+  snapshot_fields(writer);
+  std::string encoded = writer.encode();
+  if (encoded.size() > DFT_CONFIG_SNAPSHOT_MAX_SIZE) {
+    // descendants parse instead of failing exec with E2BIG
+    DFTRACER_LOG_DEBUG("ConfigurationManager not publishing %lu bytes",
+                       encoded.size());
+    unsetenv(DFTRACER_CONFIG_SNAPSHOT);
+    return;
+  }
+  setenv(DFTRACER_CONFIG_SNAPSHOT, encoded.c_str(), 1);
+}
+
 void dftracer::ConfigurationManager::derive_configurations() {
   // Derive configurations based on the current settings
   if (this->aggregation_type == AggregationType::AGGREGATION_TYPE_SELECTIVE) {
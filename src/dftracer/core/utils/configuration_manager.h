@@ -7,11 +7,24 @@
 #include <cpp-logger/logger.h>
 #include <dftracer/core/common/enumeration.h>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 namespace dftracer {
+struct SamplingRule {
+  SamplingType type;
+  // COUNT: keep 1 in value, TIME: keep one event per value us,
+  // RESERVOIR: keep value events per trace interval
+  size_t value;
+};
 class ConfigurationManager {
  private:
   void derive_configurations();
+  // DFTRACER_CONFIG_SNAPSHOT, see config_snapshot.h
+  template <typename Archive>
+  bool snapshot_fields(Archive &archive);
+  bool load_snapshot(const char *conf_file);
+  void publish_snapshot(const char *conf_file);
   std::string aggregation_file;
 
  public:
@@ -32,11 +45,48 @@ class ConfigurationManager {
   bool bind_signals;
   bool throw_error;
   size_t write_buffer_size;
+  // keep the write buffer in a memory mapped file next to the trace file
+  bool mmap_buffer;
+  // longest time events stay buffered before being written, 0 disables it
+  size_t flush_interval_ms;
+  // start a new trace segment after this many bytes or minutes, 0 disables
+  size_t rotate_size;
+  size_t rotate_minutes;
+  // node-local directory written first, drained to the log file directory
+  std::string stage_dir;
+  // bytes per second, 0 is unlimited
+  size_t stage_drain_bandwidth;
+  // how the trace file is written, see writer_backend.h
+  WriterBackendType writer_backend;
+  // bytes of the shared memory ring used with the SHM writer backend
+  size_t shm_ring_size;
+  // MPI ranks write one trace file per job at MPI_Finalize
+  bool mpi_shared_file;
   size_t trace_interval_ms;
+  bool page_cache_sampling;
+  size_t page_cache_budget;
+  bool access_pattern;
+  bool counters;
+  // minimum duration in us per function or category name
+  std::unordered_map<std::string, size_t> min_duration;
+  // sampling rule per category
+  std::unordered_map<std::string, SamplingRule> sampling;
+  bool governor;
+  // per thread budgets: events per second and percent of time in dftracer
+  size_t governor_max_events;
+  double governor_max_overhead;
+  bool coalesce;
+  size_t coalesce_gap_us;
+  // in memory ring of serialized events written out only when triggered
+  bool flight_recorder;
+  size_t flight_recorder_size;
+  size_t flight_recorder_trigger_us;
   bool aggregation_enable;
   AggregationType aggregation_type;
   std::vector<std::string> aggregation_inclusion_rules;
   std::vector<std::string> aggregation_exclusion_rules;
+  // taken from DFTRACER_CONFIG_SNAPSHOT instead of parsed
+  bool from_snapshot;
   ConfigurationManager();
   void finalize() {}
 };
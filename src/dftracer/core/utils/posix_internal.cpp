@@ -40,6 +40,16 @@ off_t df_read(int fd, void *buf, size_t count) {
   return syscall(SYS_read, fd, buf, count);
 }
 
+ssize_t df_pwrite(int fd, const void *buf, size_t count, off_t offset) {
+  DFTRACER_LOG_DEBUG("df_pwrite %d %d", fd, count);
+  return syscall(SYS_pwrite64, fd, buf, count, offset);
+}
+
+ssize_t df_pread(int fd, void *buf, size_t count, off_t offset) {
+  DFTRACER_LOG_DEBUG("df_pread %d %d", fd, count);
+  return syscall(SYS_pread64, fd, buf, count, offset);
+}
+
 int df_close(int fd) {
   DFTRACER_LOG_DEBUG("close %d", fd);
   return syscall(SYS_close, fd);
@@ -54,6 +64,51 @@ int df_unlink(const char *filename) {
 #endif
 }
 
+int df_fstat(int fd, struct stat *buf) {
+  DFTRACER_LOG_DEBUG("df_fstat %d", fd);
+#if defined(SYS_fstat)
+  return syscall(SYS_fstat, fd, buf);
+#else
+  return syscall(SYS_newfstatat, fd, "", buf, AT_EMPTY_PATH);
+#endif
+}
+
+off_t df_lseek(int fd, off_t offset, int whence) {
+  DFTRACER_LOG_DEBUG("df_lseek %d", fd);
+  return syscall(SYS_lseek, fd, offset, whence);
+}
+
+int df_ftruncate(int fd, off_t length) {
+  DFTRACER_LOG_DEBUG("df_ftruncate %d", fd);
+  return syscall(SYS_ftruncate, fd, length);
+}
+
+int df_fallocate(int fd, int mode, off_t offset, off_t length) {
+  DFTRACER_LOG_DEBUG("df_fallocate %d", fd);
+  return syscall(SYS_fallocate, fd, mode, offset, length);
+}
+
+void *df_mmap(void *addr, size_t length, int prot, int flags, int fd,
+              off_t offset) {
+  DFTRACER_LOG_DEBUG("df_mmap %d %d", fd, length);
+#if defined(SYS_mmap2)
+  return (void *)syscall(SYS_mmap2, addr, length, prot, flags, fd,
+                         offset >> 12);
+#else
+  return (void *)syscall(SYS_mmap, addr, length, prot, flags, fd, offset);
+#endif
+}
+
+int df_munmap(void *addr, size_t length) {
+  DFTRACER_LOG_DEBUG("df_munmap %d", length);
+  return syscall(SYS_munmap, addr, length);
+}
+
+int df_mincore(void *addr, size_t length, unsigned char *vec) {
+  DFTRACER_LOG_DEBUG("df_mincore %d", length);
+  return syscall(SYS_mincore, addr, length, vec);
+}
+
 int df_fsync(int fd) {  // GCOV_EXCL_START
   DFTRACER_LOG_DEBUG("df_fsync", "");
   return syscall(SYS_fsync, fd);
@@ -9,6 +9,7 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <syscall.h>
 #include <unistd.h>
@@ -21,6 +22,10 @@ ssize_t df_write(int fd, const void *buf, size_t count);
 
 ssize_t df_read(int fd, void *buf, size_t count);
 
+ssize_t df_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+ssize_t df_pread(int fd, void *buf, size_t count, off_t offset);
+
 int df_close(int fd);
 
 int df_fsync(int fd);
@@ -29,6 +34,21 @@ ssize_t df_readlink(const char *path, char *buf, size_t bufsize);
 
 int df_unlink(const char *filename);
 
+int df_fstat(int fd, struct stat *buf);
+
+off_t df_lseek(int fd, off_t offset, int whence);
+
+int df_ftruncate(int fd, off_t length);
+
+int df_fallocate(int fd, int mode, off_t offset, off_t length);
+
+void *df_mmap(void *addr, size_t length, int prot, int flags, int fd,
+              off_t offset);
+
+int df_munmap(void *addr, size_t length);
+
+int df_mincore(void *addr, size_t length, unsigned char *vec);
+
 ThreadID df_gettid();
 
 ProcessID df_getpid();
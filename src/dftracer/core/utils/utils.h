@@ -21,6 +21,7 @@
 #include <vector>
 
 void dft_finalize(bool force = false);
+void dft_flight_recorder_request(const char* reason);
 
 inline void signal_handler(int sig) {  // GCOVR_EXCL_START
   DFTRACER_LOG_DEBUG("signal_handler", "");
@@ -28,12 +29,14 @@ inline void signal_handler(int sig) {  // GCOVR_EXCL_START
     case SIGINT:
     case SIGTERM: {
       DFTRACER_LOG_ERROR("signal caught %d", sig);
+      dft_flight_recorder_request("signal");
       dft_finalize();
       exit(0);
       break;
     }
     default: {
       DFTRACER_LOG_ERROR("signal caught %d", sig);
+      dft_flight_recorder_request("crash");
       dft_finalize();
       int j, nptrs;
       const int STACK_SIZE = 40;
@@ -55,10 +58,26 @@ inline void signal_handler(int sig) {  // GCOVR_EXCL_START
 inline void signal_handler_simple(int sig) {  // GCOVR_EXCL_START
   DFTRACER_LOG_DEBUG("signal_handler", "");
   DFTRACER_LOG_INFO("signal caught %d", sig);
+  dft_flight_recorder_request("signal");
   dft_finalize();
   exit(sig);
 }
 
+// only marks the flight recorder, the next traced event or finalize dumps it
+inline void flight_recorder_signal_handler(int sig) {  // GCOVR_EXCL_START
+  (void)sig;
+  dft_flight_recorder_request("SIGUSR2");
+}
+
+inline void set_flight_recorder_signal() {
+  DFTRACER_LOG_DEBUG("set_flight_recorder_signal", "");
+  struct sigaction sa;
+  sa.sa_handler = flight_recorder_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGUSR2, &sa, NULL);
+}  // GCOVR_EXCL_STOP
+
 inline void set_signal(bool debug_symbols = true) {
   DFTRACER_LOG_DEBUG("set_signal", "");
   struct sigaction sa;
@@ -0,0 +1,185 @@
+#include <dftracer/core/writer/mpi_shared_file.h>
+//
+#include <dftracer/core/buffer/buffer.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/utils/configuration_manager.h>
+#include <dftracer/core/utils/posix_internal.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace dftracer {
+std::string shared_trace_name(const std::string &filename) {
+  size_t ext = filename.rfind(".pfw");
+  if (ext == std::string::npos) ext = filename.size();
+  return filename.substr(0, ext) + DFT_MPI_SHARED_SUFFIX +
+         filename.substr(ext);
+}
+
+#ifdef DFTRACER_MPI_ENABLE
+// one JSON line for the file, then one per chunk in file order
+static void write_index(const std::string &name,
+                        const std::vector<int> &counts,
+                        const std::vector<uint64_t> &offsets,
+                        const std::vector<uint64_t> &blocks) {
+  std::string index = name + DFT_MPI_SHARED_INDEX;
+  std::string lines;
+  size_t slash = name.rfind('/');
+  lines += "{\"file\":\"" +
+           (slash == std::string::npos ? name : name.substr(slash + 1)) +
+           "\",\"ranks\":" + std::to_string(counts.size()) +
+           ",\"blocks\":" + std::to_string(blocks.size()) + "}\n";
+  size_t block = 0;
+  for (size_t rank = 0; rank < counts.size(); ++rank) {
+    uint64_t offset = offsets[rank];
+    for (int i = 0; i < counts[rank]; ++i, ++block) {
+      lines += "{\"rank\":" + std::to_string(rank) +
+               ",\"offset\":" + std::to_string(offset) +
+               ",\"size\":" + std::to_string(blocks[block]) + "}\n";
+      offset += blocks[block];
+    }
+  }
+  int fd = df_open(index.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bool ok = fd != -1 && df_write(fd, lines.data(), lines.size()) ==
+                            (ssize_t)lines.size();
+  if (fd != -1) df_close(fd);
+  if (!ok) {
+    DFTRACER_LOG_ERROR("unable to write shared trace index %s: %s",
+                       index.c_str(), strerror(errno));
+  }
+}
+
+bool write_shared_trace(MPI_Comm comm, const std::string &target,
+                        const std::string &staged,
+                        const std::vector<uint64_t> &blocks) {
+  int rank = 0, ranks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &ranks);
+  DFTRACER_LOG_DEBUG("write_shared_trace %d %s", rank, staged.c_str());
+  // the lowest rank with a trace names the file
+  int root = staged.empty() ? INT_MAX : rank;
+  MPI_Allreduce(MPI_IN_PLACE, &root, 1, MPI_INT, MPI_MIN, comm);
+  if (root == INT_MAX) return false;
+  std::string name = shared_trace_name(target);
+  int length = name.size();
+  MPI_Bcast(&length, 1, MPI_INT, root, comm);
+  name.resize(length);
+  MPI_Bcast(&name[0], length, MPI_CHAR, root, comm);
+
+  int fd = -1;
+  uint64_t local = 0;
+  if (!staged.empty()) {
+    struct stat st;
+    fd = df_open(staged.c_str(), O_RDONLY);
+    if (fd != -1 && df_fstat(fd, &st) == 0) local = st.st_size;
+  }
+  uint64_t offset = 0;
+  MPI_Exscan(&local, &offset, 1, MPI_UINT64_T, MPI_SUM, comm);
+  if (rank == 0) offset = 0;
+
+  MPI_Info info;
+  MPI_Info_create(&info);
+  // collective buffering lets aggregators write stripe aligned pieces
+  MPI_Info_set(info, "romio_cb_write", "enable");
+  MPI_File fh;
+  int status = MPI_File_open(comm, name.c_str(),
+                             MPI_MODE_CREATE | MPI_MODE_WRONLY, info, &fh);
+  MPI_Info_free(&info);
+  int opened = status == MPI_SUCCESS;
+  MPI_Allreduce(MPI_IN_PLACE, &opened, 1, MPI_INT, MPI_LAND, comm);
+  if (!opened) {
+    if (status == MPI_SUCCESS) MPI_File_close(&fh);
+    if (fd != -1) df_close(fd);
+    DFTRACER_LOG_ERROR("unable to open shared trace %s", name.c_str());
+    return false;
+  }
+
+  // every rank takes part in every round, those that are done with count 0
+  uint64_t rounds = (local + DFT_MPI_SHARED_CHUNK - 1) / DFT_MPI_SHARED_CHUNK;
+  MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_UINT64_T, MPI_MAX, comm);
+  std::vector<char> chunk(std::min<uint64_t>(local, DFT_MPI_SHARED_CHUNK));
+  int ok = 1;
+  uint64_t done = 0;
+  for (uint64_t round = 0; round < rounds; ++round) {
+    int count = ok ? std::min<uint64_t>(local - done, DFT_MPI_SHARED_CHUNK) : 0;
+    if (count > 0 && df_pread(fd, chunk.data(), count, done) != count) {
+      ok = 0;
+      count = 0;
+    }
+    MPI_Status write_status;
+    if (MPI_File_write_at_all(fh, (MPI_Offset)(offset + done), chunk.data(),
+                              count, MPI_BYTE,
+                              &write_status) != MPI_SUCCESS) {
+      ok = 0;
+    }
+    done += count;
+  }
+  MPI_File_close(&fh);
+  if (fd != -1) df_close(fd);
+  ok = ok && done == local;
+  MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+  if (!ok) {
+    if (rank == 0) MPI_File_delete(name.c_str(), MPI_INFO_NULL);
+    DFTRACER_LOG_ERROR("unable to write shared trace %s", name.c_str());
+    return false;
+  }
+
+  // chunks that do not add up to the file are indexed as one block
+  std::vector<uint64_t> local_blocks = blocks;
+  uint64_t total = 0;
+  for (auto size : blocks) total += size;
+  if (total != local) {
+    local_blocks.clear();
+    if (local > 0) local_blocks.push_back(local);
+  }
+  int count = local_blocks.size();
+  std::vector<int> counts(rank == 0 ? ranks : 0);
+  std::vector<uint64_t> offsets(rank == 0 ? ranks : 0);
+  MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+  MPI_Gather(&offset, 1, MPI_UINT64_T, offsets.data(), 1, MPI_UINT64_T, 0,
+             comm);
+  std::vector<int> displs(counts.size(), 0);
+  for (size_t i = 1; i < counts.size(); ++i) {
+    displs[i] = displs[i - 1] + counts[i - 1];
+  }
+  std::vector<uint64_t> all_blocks(
+      counts.empty() ? 0 : displs.back() + counts.back());
+  MPI_Gatherv(local_blocks.data(), count, MPI_UINT64_T, all_blocks.data(),
+              counts.data(), displs.data(), MPI_UINT64_T, 0, comm);
+  if (rank == 0) {
+    write_index(name, counts, offsets, all_blocks);
+    DFTRACER_LOG_INFO("wrote shared trace %s for %d ranks", name.c_str(),
+                      ranks);
+  }
+  return true;
+}
+#endif
+}  // namespace dftracer
+
+#ifdef DFTRACER_MPI_ENABLE
+// the trace written before MPI_Finalize goes into the shared file while the
+// ranks can still communicate; events after it stay in the file of the rank
+extern "C" int MPI_Finalize(void) {
+  auto conf =
+      dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  if (conf != nullptr && conf->enable && conf->mpi_shared_file) {
+    std::vector<uint64_t> blocks;
+    std::string target;
+    std::string staged;
+    auto buffer_manager =
+        dftracer::Singleton<dftracer::BufferManager>::get_instance();
+    if (buffer_manager != nullptr) {
+      staged = buffer_manager->handoff(blocks, target);
+    }
+    bool written =
+        dftracer::write_shared_trace(MPI_COMM_WORLD, target, staged, blocks);
+    if (buffer_manager != nullptr) {
+      buffer_manager->release_handoff(staged, written);
+    }
+  }
+  return PMPI_Finalize();
+}
+#endif
@@ -0,0 +1,40 @@
+#ifndef DFTRACER_MPI_SHARED_FILE_H
+#define DFTRACER_MPI_SHARED_FILE_H
+#include <dftracer/core/common/logging.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#ifdef DFTRACER_MPI_ENABLE
+#include <mpi.h>
+#endif
+
+namespace dftracer {
+// bytes each rank writes per collective call
+#define DFT_MPI_SHARED_CHUNK (16 * 1024 * 1024)
+#define DFT_MPI_SHARED_SUFFIX "-shared"
+#define DFT_MPI_SHARED_INDEX ".index"
+
+// <log file>-shared.pfw[.gz], named after the log file of the lowest rank
+std::string shared_trace_name(const std::string &filename);
+
+#ifdef DFTRACER_MPI_ENABLE
+/**
+ * Writes one trace file for all ranks of comm. Every rank stages its trace
+ * on node-local storage; at MPI_Finalize the ranks exchange their sizes with
+ * MPI_Exscan and copy the staged files back to back into the shared file
+ * with MPI_File_write_at_all, one DFT_MPI_SHARED_CHUNK per rank and call, so
+ * the file system sees a single file and large collective writes. Rank 0
+ * then writes <shared file>.index with the rank, offset and size of every
+ * compressed chunk.
+ *
+ * Collective over comm. Ranks without a trace pass an empty staged name.
+ * Returns false on every rank if the shared file could not be written, in
+ * which case it is removed again.
+ */
+bool write_shared_trace(MPI_Comm comm, const std::string &target,
+                        const std::string &staged,
+                        const std::vector<uint64_t> &blocks);
+#endif
+}  // namespace dftracer
+#endif  // DFTRACER_MPI_SHARED_FILE_H
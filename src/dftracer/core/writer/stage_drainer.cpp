@@ -0,0 +1,114 @@
+#include <dftracer/core/utils/posix_internal.h>
+#include <dftracer/core/writer/stage_drainer.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace dftracer {
+static const size_t STAGE_DRAIN_CHUNK = 4 * 1024 * 1024;
+
+void StageDrainer::drain(const std::string &staged,
+                         const std::string &target) {
+  DFTRACER_LOG_DEBUG("StageDrainer.drain %s", staged.c_str());
+  std::lock_guard<std::mutex> lock(mtx);
+  queue.emplace_back(staged, target);
+  if (!worker.joinable()) worker = std::thread(&StageDrainer::run, this);
+  cv.notify_one();
+}
+
+void StageDrainer::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    cv.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (queue.empty()) return;
+    auto next = queue.front();
+    queue.pop_front();
+    lock.unlock();
+    move(next.first, next.second, true);
+    lock.lock();
+  }
+}
+
+void StageDrainer::finish(const std::string &staged,
+                          const std::string &target) {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+    cv.notify_all();
+  }
+  if (worker.joinable()) worker.join();
+  // the thread stops once the queue is empty, so whatever is left was queued
+  // after it exited
+  while (!queue.empty()) {
+    auto next = queue.front();
+    queue.pop_front();
+    move(next.first, next.second, false);
+  }
+  if (!staged.empty()) move(staged, target, false);
+}
+
+// the thread does not exist in the child, so its handle is overwritten
+// rather than joined and its lock may be held
+void StageDrainer::forked() {
+  new (&mtx) std::mutex();
+  new (&cv) std::condition_variable();
+  new (&worker) std::thread();
+  queue.clear();
+  stopping = false;
+}
+
+bool StageDrainer::move(const std::string &staged, const std::string &target,
+                        bool limited) {
+  DFTRACER_LOG_DEBUG("StageDrainer.move %s %s", staged.c_str(),
+                     target.c_str());
+  // same file system, nothing to copy
+  if (rename(staged.c_str(), target.c_str()) == 0) return true;
+  if (errno != EXDEV) {
+    DFTRACER_LOG_ERROR("unable to move %s to %s: %s", staged.c_str(),
+                       target.c_str(), strerror(errno));
+    return false;
+  }
+  int in = df_open(staged.c_str(), O_RDONLY);
+  int out = df_open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bool ok = in != -1 && out != -1;
+  std::vector<char> chunk(STAGE_DRAIN_CHUNK);
+  size_t total = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (ok) {
+    ssize_t got = df_read(in, chunk.data(), chunk.size());
+    if (got <= 0) {
+      ok = got == 0;
+      break;
+    }
+    ssize_t put = 0;
+    while (put < got) {
+      ssize_t written = df_write(out, chunk.data() + put, got - put);
+      if (written <= 0) break;
+      put += written;
+    }
+    if (put < got) {
+      ok = false;
+      break;
+    }
+    total += got;
+    // finish() lifts the limit for whatever is still being drained
+    if (limited && bandwidth > 0 && !stopping) {
+      auto due = start + std::chrono::microseconds(total * 1000000 / bandwidth);
+      std::this_thread::sleep_until(due);
+    }
+  }
+  if (in != -1) df_close(in);
+  if (out != -1) df_close(out);
+  if (ok) {
+    df_unlink(staged.c_str());
+  } else {
+    DFTRACER_LOG_ERROR("unable to drain %s to %s, it is left in place",
+                       staged.c_str(), target.c_str());
+    df_unlink(target.c_str());
+  }
+  return ok;
+}
+}  // namespace dftracer
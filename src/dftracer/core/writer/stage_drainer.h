@@ -0,0 +1,60 @@
+#ifndef DFTRACER_STAGE_DRAINER_H
+#define DFTRACER_STAGE_DRAINER_H
+#include <dftracer/core/common/logging.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace dftracer {
+/**
+ * Moves trace files written to node-local staging storage into the log
+ * file directory. Completed segments are drained by a background thread at
+ * no more than the configured bandwidth so the parallel file system only
+ * sees a few large sequential writes per process. The thread is started on
+ * the first segment; finish() drains what is left without a limit.
+ */
+class StageDrainer {
+ private:
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<std::pair<std::string, std::string>> queue;
+  std::thread worker;
+  std::atomic<bool> stopping;
+  // bytes per second, 0 is unlimited
+  size_t bandwidth;
+
+  void run();
+  bool move(const std::string &staged, const std::string &target,
+            bool limited);
+
+ public:
+  explicit StageDrainer(size_t bandwidth)
+      : mtx(),
+        cv(),
+        queue(),
+        worker(),
+        stopping(false),
+        bandwidth(bandwidth) {
+    DFTRACER_LOG_DEBUG("StageDrainer.StageDrainer", "");
+  }
+  ~StageDrainer() { finish(); }
+
+  // queues a completed staged file for the background thread
+  void drain(const std::string &staged, const std::string &target);
+
+  // moves the tail and anything still queued, then stops the thread
+  void finish(const std::string &staged = std::string(),
+              const std::string &target = std::string());
+
+  // in a forked child: the thread and the queued files belong to the
+  // parent, which still drains them
+  void forked();
+};
+}  // namespace dftracer
+#endif  // DFTRACER_STAGE_DRAINER_H
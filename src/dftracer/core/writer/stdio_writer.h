@@ -2,75 +2,255 @@
 #include <dftracer/core/common/logging.h>
 #include <dftracer/core/common/singleton.h>
 #include <dftracer/core/utils/configuration_manager.h>
+#include <dftracer/core/writer/stage_drainer.h>
+#include <dftracer/core/writer/writer_backend.h>
 
 #include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <stdexcept>
+#include <string>
+#include <vector>
 namespace dftracer {
+// Names, rotates and stages trace files; the bytes are written by the
+// configured WriterBackend, stdio by default. With the SHM backend the trace
+// goes to dftracer_service instead and no local file is created unless the
+// service is not running. With a shared MPI file the trace is staged until
+// MPI_Finalize copies it into the file of the job.
 class STDIOWriter {
  public:
-  STDIOWriter() : max_size_(0), fh_(nullptr) {}
+  STDIOWriter()
+      : filename(),
+        base_filename(),
+        target_(),
+        stage_dir_(),
+        drainer_(),
+        max_size_(0),
+        backend_type_(WriterBackendType::WRITER_BACKEND_STDIO),
+        backend_(),
+        ring_size_(0),
+        mpi_shared_(false),
+        blocks_(),
+        handoff_target_(),
+        rotate_size_(0),
+        rotate_seconds_(0),
+        segment_(0),
+        segment_bytes_(0),
+        segment_start_(0) {}
   void initialize(const char* filename) {
-    this->filename = filename;
+    base_filename = filename;
     auto conf =
         dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
     max_size_ = conf->write_buffer_size;
-    fh_ = fopen(filename, "ab+");
-    if (fh_ == nullptr) {
-      DFTRACER_LOG_ERROR("unable to create log file %s: errno=%d (%s)",
-                         filename, errno, strerror(errno));  // GCOVR_EXCL_LINE
-    } else {
-      setvbuf(fh_, NULL, _IOLBF, max_size_ + 16 * 1024);
-      DFTRACER_LOG_INFO("created log file %s", filename);
+    backend_type_ = conf->writer_backend;
+    ring_size_ = conf->shm_ring_size;
+    rotate_size_ = conf->rotate_size;
+    rotate_seconds_ = conf->rotate_minutes * 60;
+    stage_dir_ = conf->stage_dir;
+    segment_ = 0;
+    mpi_shared_ = false;
+    blocks_.clear();
+    if (shared()) {
+      this->filename = base_filename;
+      target_ = base_filename;
+      backend_ = make_writer_backend(backend_type_, max_size_, ring_size_);
+      if (backend_->open(filename)) return;
+      DFTRACER_LOG_INFO("dftracer_service not running, writing %s", filename);
+      backend_type_ = WriterBackendType::WRITER_BACKEND_STDIO;
+    }
+    // staged so that no file per rank reaches the log file directory; it is
+    // only drained there if the shared file is never written
+    mpi_shared_ = conf->mpi_shared_file;
+    if (mpi_shared_ && stage_dir_.empty()) stage_dir_ = "/tmp";
+    if (!stage_dir_.empty()) {
+      drainer_ = std::make_shared<StageDrainer>(conf->stage_drain_bandwidth);
     }
+    open(rotating() ? segment_name(segment_) : base_filename);
   }
 
   void initialize() {}
 
   ~STDIOWriter() {}
   void finalize(int index) {
-    if (fh_ != nullptr) {
+    if (backend_ != nullptr) {
       DFTRACER_LOG_INFO("Finalizing STDIOWriter", "");
-      fflush(fh_);
-      long file_size = 0;
-      if (fh_ != nullptr) {
-        fseek(fh_, 0, SEEK_END);
-        file_size = ftell(fh_);
-        fseek(fh_, 0, SEEK_SET);
+      size_t file_size = backend_->size();
+      int status = backend_->close();
+      bool discard = index < 5 || file_size == 0;
+      if (discard && !shared() && !filename.empty()) {
+        unlink(filename.c_str());
       }
-      int status = fclose(fh_);
-      if ((index < 5 || file_size == 0) && filename != nullptr) {
-        unlink(filename);
+      if (drainer_ != nullptr) {
+        // only the tail is left, earlier segments are drained already
+        if (discard) {
+          drainer_->finish();
+        } else {
+          drainer_->finish(filename, target_);
+        }
+        drainer_.reset();
       }
       if (status != 0) {
         DFTRACER_LOG_ERROR("unable to close log file %s",
-                           this->filename);  // GCOVR_EXCL_LINE
+                           this->filename.c_str());  // GCOVR_EXCL_LINE
       }
-      fh_ = nullptr;
+      backend_.reset();
+    }
+  }
+
+  void flush() {
+    if (backend_ != nullptr) backend_->flush();
+  }
+
+  // current size of the log file including everything written so far
+  size_t size() { return backend_ != nullptr ? backend_->size() : 0; }
+
+  inline const char* get_filename() const { return filename.c_str(); }
+
+  // the events go to dftracer_service rather than a local file
+  inline bool shared() const {
+    return backend_type_ == WriterBackendType::WRITER_BACKEND_SHM;
+  }
+
+  // the file written so far goes into the shared MPI file at MPI_Finalize
+  inline bool mpi_shared() const { return mpi_shared_; }
+
+  inline bool rotating() const {
+    return !shared() && !mpi_shared_ &&
+           (rotate_size_ > 0 || rotate_seconds_ > 0);
+  }
+
+  // the current segment reached its size or age limit
+  inline bool needs_rotation() const {
+    if (!rotating() || backend_ == nullptr || segment_bytes_ == 0) {
+      return false;
+    }
+    if (rotate_size_ > 0 && segment_bytes_ >= rotate_size_) return true;
+    return rotate_seconds_ > 0 &&
+           (size_t)(time(nullptr) - segment_start_) >= rotate_seconds_;
+  }
+
+  // closes the current segment and opens the next one
+  void rotate() {
+    if (backend_ != nullptr) {
+      if (backend_->close() != 0) {
+        DFTRACER_LOG_ERROR("unable to close log file %s",
+                           this->filename.c_str());  // GCOVR_EXCL_LINE
+      }
+      backend_.reset();
+      if (drainer_ != nullptr) drainer_->drain(filename, target_);
+    }
+    open(segment_name(++segment_));
+  }
+
+  // closes the staged file for the shared MPI file and moves its chunk sizes
+  // to blocks. Events that follow go to the next segment, a regular staged
+  // file drained at finalize.
+  std::string handoff(std::vector<uint64_t>& blocks) {
+    std::string staged;
+    if (backend_ == nullptr || !mpi_shared_) return staged;
+    if (backend_->close() != 0) {
+      DFTRACER_LOG_ERROR("unable to close log file %s",
+                         this->filename.c_str());  // GCOVR_EXCL_LINE
+    }
+    backend_.reset();
+    staged = filename;
+    handoff_target_ = target_;
+    blocks.swap(blocks_);
+    blocks_.clear();
+    mpi_shared_ = false;
+    open(segment_name(++segment_));
+    return staged;
+  }
+
+  inline const std::string& handoff_target() const { return handoff_target_; }
+
+  // in a forked child: lets go of the parent's file and staging thread
+  // without touching either, initialize then opens the child's own file
+  void forked() {
+    if (backend_ != nullptr) backend_->detach();
+    backend_.reset();
+    if (drainer_ != nullptr) drainer_->forked();
+    drainer_.reset();
+    blocks_.clear();
+  }
+
+  // removes the staged file once it is in the shared file, otherwise it is
+  // drained to its own trace file like any other segment
+  void release(const std::string& staged, bool written) {
+    if (staged.empty()) return;
+    if (written) {
+      unlink(staged.c_str());
+    } else if (drainer_ != nullptr) {
+      drainer_->drain(staged, handoff_target_);
     }
   }
 
   // Write data to buffer, flush if necessary
   size_t write(const char* data, size_t len, bool force = false) {
-    if (fh_ != nullptr && (force || len >= max_size_)) {
-      // Use stdio file locking (flockfile/funlockfile) for FILE*
-      // needed for fork and spawn cases to maintain consistency
-      // Note this may not work with nfs and should typically either create a
-      // new file per fork or use a local filesystem which supports flockfile.
-      flockfile(fh_);
-      auto written = std::fwrite(data, 1, len, fh_);
-      funlockfile(fh_);
+    if (backend_ != nullptr && (force || len >= max_size_)) {
+      auto written = backend_->write(data, len);
+      segment_bytes_ += written;
+      if (mpi_shared_ && written > 0) blocks_.push_back(written);
       if (written != len) {
         DFTRACER_LOG_ERROR("unable to write log file %s",
-                           this->filename);  // GCOVR_EXCL_LINE
+                           this->filename.c_str());  // GCOVR_EXCL_LINE
       }
     }
     return len;
   }
 
  private:
-  const char* filename;
+  // with a staging directory the file is written there under the same name
+  // and moved to name by the drainer
+  void open(const std::string& name) {
+    target_ = name;
+    filename = name;
+    if (!stage_dir_.empty()) {
+      size_t slash = name.rfind('/');
+      filename = stage_dir_ + "/" +
+                 (slash == std::string::npos ? name : name.substr(slash + 1));
+    }
+    segment_bytes_ = 0;
+    segment_start_ = time(nullptr);
+    backend_ = make_writer_backend(backend_type_, max_size_);
+    if (!backend_->open(filename.c_str())) {
+      DFTRACER_LOG_ERROR("unable to create log file %s: errno=%d (%s)",
+                         filename.c_str(), errno,
+                         strerror(errno));  // GCOVR_EXCL_LINE
+      backend_.reset();
+    } else {
+      DFTRACER_LOG_INFO("created log file %s with %s writer",
+                        filename.c_str(), to_string(backend_type_).c_str());
+    }
+  }
+
+  // <name>.<segment>.pfw[.gz] so segments sort and keep the trace extension
+  std::string segment_name(size_t segment) const {
+    size_t ext = base_filename.rfind(".pfw");
+    if (ext == std::string::npos) ext = base_filename.size();
+    char number[32];
+    snprintf(number, sizeof(number), ".%04zu", segment);
+    return base_filename.substr(0, ext) + number + base_filename.substr(ext);
+  }
+
+  // file being written and, when staging, where it ends up
+  std::string filename;
+  std::string base_filename;
+  std::string target_;
+  std::string stage_dir_;
+  std::shared_ptr<StageDrainer> drainer_;
   size_t max_size_;
-  FILE* fh_;
+  WriterBackendType backend_type_;
+  std::shared_ptr<WriterBackend> backend_;
+  size_t ring_size_;
+  bool mpi_shared_;
+  // sizes of the chunks written to the file for the shared file index
+  std::vector<uint64_t> blocks_;
+  std::string handoff_target_;
+  size_t rotate_size_;
+  size_t rotate_seconds_;
+  size_t segment_;
+  size_t segment_bytes_;
+  time_t segment_start_;
 };
 }  // namespace dftracer
\ No newline at end of file
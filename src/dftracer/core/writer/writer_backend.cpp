@@ -0,0 +1,527 @@
+#include <dftracer/core/common/logging.h>
+#include <dftracer/core/utils/posix_internal.h>
+#include <dftracer/core/writer/writer_backend.h>
+#include <linux/falloc.h>
+#include <stdio_ext.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__NR_io_uring_setup) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define DFTRACER_IO_URING_WRITER 1
+#endif
+
+namespace dftracer {
+static const size_t WRITER_EXTENT = 16 * 1024 * 1024;
+static const size_t DIRECT_ALIGN = 4096;
+static const unsigned IO_URING_DEPTH = 8;
+
+static inline size_t align_up(size_t value, size_t align) {
+  return (value + align - 1) / align * align;
+}
+
+bool StdioBackend::open(const char *filename) {
+  fh_ = fopen(filename, "ab+");
+  if (fh_ == nullptr) return false;
+  setvbuf(fh_, NULL, _IOLBF, buffer_size_ + 16 * 1024);
+  return true;
+}
+
+size_t StdioBackend::write(const char *data, size_t len) {
+  // Use stdio file locking (flockfile/funlockfile) for FILE*
+  // needed for fork and spawn cases to maintain consistency
+  // Note this may not work with nfs and should typically either create a
+  // new file per fork or use a local filesystem which supports flockfile.
+  flockfile(fh_);
+  auto written = std::fwrite(data, 1, len, fh_);
+  funlockfile(fh_);
+  return written;
+}
+
+void StdioBackend::flush() { fflush(fh_); }
+
+size_t StdioBackend::size() {
+  struct stat st;
+  fflush(fh_);
+  if (fstat(fileno(fh_), &st) != 0) return 0;
+  return st.st_size;
+}
+
+int StdioBackend::close() {
+  int status = fclose(fh_);
+  fh_ = nullptr;
+  return status;
+}
+
+// the parent flushed before the fork, purging keeps fclose from writing
+// anything the stream may still hold
+void StdioBackend::detach() {
+  if (fh_ == nullptr) return;
+  __fpurge(fh_);
+  fclose(fh_);
+  fh_ = nullptr;
+}
+
+PwriteBackend::PwriteBackend(size_t buffer_size)
+    : fd_(-1),
+      offset_(0),
+      allocated_(0),
+      extent_(std::max(WRITER_EXTENT, 4 * buffer_size)) {}
+
+bool PwriteBackend::open(const char *filename) {
+  return open_fd(filename, O_WRONLY | O_CREAT | O_CLOEXEC);
+}
+
+bool PwriteBackend::open_fd(const char *filename, int flags) {
+  fd_ = df_open(filename, flags, 0644);
+  if (fd_ == -1) return false;
+  struct stat st;
+  offset_ = df_fstat(fd_, &st) == 0 ? st.st_size : 0;
+  allocated_ = offset_;
+  return true;
+}
+
+// KEEP_SIZE leaves the file size at what was written so a crash does not
+// leave zeros at the end of the trace
+void PwriteBackend::preallocate(size_t end) {
+  if (extent_ == 0 || (off_t)end <= allocated_) return;
+  off_t length = std::max((off_t)extent_, (off_t)end - allocated_);
+  if (df_fallocate(fd_, FALLOC_FL_KEEP_SIZE, allocated_, length) == 0) {
+    allocated_ += length;
+  } else {
+    DFTRACER_LOG_DEBUG("PwriteBackend.preallocate not supported errno=%d",
+                       errno);
+    extent_ = 0;
+  }
+}
+
+size_t PwriteBackend::write_at(const char *data, size_t len, off_t offset) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t ret = df_pwrite(fd_, data + done, len - done, offset + done);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret <= 0) {
+      DFTRACER_LOG_ERROR("unable to write log file: errno=%d (%s)", errno,
+                         strerror(errno));  // GCOVR_EXCL_LINE
+      break;
+    }
+    done += ret;
+  }
+  return done;
+}
+
+size_t PwriteBackend::write(const char *data, size_t len) {
+  preallocate(offset_ + len);
+  size_t written = write_at(data, len, offset_);
+  offset_ += written;
+  return written;
+}
+
+int PwriteBackend::close() {
+  if (fd_ == -1) return 0;
+  // releases the unused part of the last extent
+  if (allocated_ > offset_) df_ftruncate(fd_, offset_);
+  int status = df_close(fd_);
+  fd_ = -1;
+  return status;
+}
+
+void PwriteBackend::detach() {
+  if (fd_ != -1) df_close(fd_);
+  fd_ = -1;
+}
+
+DirectBackend::DirectBackend(size_t buffer_size)
+    : PwriteBackend(buffer_size),
+      stage_(nullptr),
+      capacity_(align_up(std::max(buffer_size, (size_t)1024 * 1024),
+                         DIRECT_ALIGN)),
+      staged_(0) {}
+
+DirectBackend::~DirectBackend() { free(stage_); }
+
+bool DirectBackend::open(const char *filename) {
+  if (stage_ == nullptr &&
+      posix_memalign((void **)&stage_, DIRECT_ALIGN, capacity_) != 0) {
+    stage_ = nullptr;
+    return false;
+  }
+  staged_ = 0;
+  if (!open_fd(filename, O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT)) {
+    if (errno != EINVAL) return false;
+    DFTRACER_LOG_WARN("O_DIRECT not supported for %s, using buffered writes",
+                      filename);
+    if (!open_fd(filename, O_RDWR | O_CREAT | O_CLOEXEC)) return false;
+  }
+  // appending to an existing file restarts at its last partial block
+  staged_ = offset_ % DIRECT_ALIGN;
+  offset_ -= staged_;
+  if (staged_ > 0 && df_pread(fd_, stage_, DIRECT_ALIGN, offset_) < 0) {
+    DFTRACER_LOG_ERROR("unable to read log file %s", filename);
+  }
+  return true;
+}
+
+size_t DirectBackend::write(const char *data, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    size_t n = std::min(len - done, capacity_ - staged_);
+    memcpy(stage_ + staged_, data + done, n);
+    staged_ += n;
+    done += n;
+    if (staged_ == capacity_) {
+      preallocate(offset_ + capacity_);
+      write_at(stage_, capacity_, offset_);
+      offset_ += capacity_;
+      staged_ = 0;
+    }
+  }
+  return len;
+}
+
+// the padded block is rewritten by the next full write
+void DirectBackend::flush() {
+  if (staged_ == 0) return;
+  size_t padded = align_up(staged_, DIRECT_ALIGN);
+  memset(stage_ + staged_, 0, padded - staged_);
+  write_at(stage_, padded, offset_);
+  df_ftruncate(fd_, offset_ + staged_);
+  allocated_ = offset_ + staged_;
+}
+
+size_t DirectBackend::size() {
+  flush();
+  return offset_ + staged_;
+}
+
+int DirectBackend::close() {
+  if (fd_ == -1) return 0;
+  flush();
+  offset_ += staged_;
+  staged_ = 0;
+  return PwriteBackend::close();
+}
+
+void DirectBackend::detach() {
+  staged_ = 0;
+  PwriteBackend::detach();
+}
+
+struct IOUringBackend::Ring {
+  int fd;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  void *sqes;
+  size_t sqes_size;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  void *cqes;
+};
+
+IOUringBackend::IOUringBackend(size_t buffer_size)
+    : PwriteBackend(buffer_size),
+      ring_(nullptr),
+      slots_(IO_URING_DEPTH),
+      in_flight_(0) {}
+
+IOUringBackend::~IOUringBackend() { teardown(); }
+
+bool IOUringBackend::open(const char *filename) {
+  if (!PwriteBackend::open(filename)) return false;
+  if (!setup()) {
+    DFTRACER_LOG_INFO("io_uring not available, using pwrite for %s",
+                      filename);
+  }
+  return true;
+}
+
+bool IOUringBackend::setup() {
+#ifdef DFTRACER_IO_URING_WRITER
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, IO_URING_DEPTH, &params);
+  if (fd < 0) return false;
+  ring_ = new Ring();
+  memset(ring_, 0, sizeof(Ring));
+  ring_->fd = fd;
+  ring_->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring_->cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    ring_->sq_size = ring_->cq_size = std::max(ring_->sq_size, ring_->cq_size);
+  }
+  int prot = PROT_READ | PROT_WRITE;
+  int flags = MAP_SHARED | MAP_POPULATE;
+  ring_->sq_ptr =
+      df_mmap(nullptr, ring_->sq_size, prot, flags, fd, IORING_OFF_SQ_RING);
+  if (ring_->sq_ptr == MAP_FAILED) ring_->sq_ptr = nullptr;
+  ring_->cq_ptr = single ? nullptr
+                         : df_mmap(nullptr, ring_->cq_size, prot, flags, fd,
+                                   IORING_OFF_CQ_RING);
+  if (ring_->cq_ptr == MAP_FAILED) ring_->cq_ptr = nullptr;
+  ring_->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring_->sqes =
+      df_mmap(nullptr, ring_->sqes_size, prot, flags, fd, IORING_OFF_SQES);
+  if (ring_->sqes == MAP_FAILED) ring_->sqes = nullptr;
+  if (ring_->sq_ptr == nullptr || ring_->sqes == nullptr ||
+      (!single && ring_->cq_ptr == nullptr)) {
+    teardown();
+    return false;
+  }
+  char *sq = (char *)ring_->sq_ptr;
+  char *cq = single ? sq : (char *)ring_->cq_ptr;
+  ring_->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring_->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring_->sq_array = (unsigned *)(sq + params.sq_off.array);
+  ring_->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring_->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring_->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring_->cqes = cq + params.cq_off.cqes;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void IOUringBackend::teardown() {
+  if (ring_ == nullptr) return;
+  if (ring_->sqes != nullptr) df_munmap(ring_->sqes, ring_->sqes_size);
+  if (ring_->cq_ptr != nullptr) df_munmap(ring_->cq_ptr, ring_->cq_size);
+  if (ring_->sq_ptr != nullptr) df_munmap(ring_->sq_ptr, ring_->sq_size);
+  df_close(ring_->fd);
+  delete ring_;
+  ring_ = nullptr;
+}
+
+void IOUringBackend::submit(size_t index) {
+#ifdef DFTRACER_IO_URING_WRITER
+  Slot &slot = slots_[index];
+  unsigned tail = *ring_->sq_tail;
+  unsigned entry = tail & *ring_->sq_mask;
+  auto sqe = (struct io_uring_sqe *)ring_->sqes + entry;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = fd_;
+  sqe->addr = (uint64_t)(uintptr_t)&slot.iov;
+  sqe->len = 1;
+  sqe->off = slot.offset;
+  sqe->user_data = index;
+  ring_->sq_array[entry] = entry;
+  __atomic_store_n(ring_->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  long ret;
+  do {
+    ret = syscall(__NR_io_uring_enter, ring_->fd, 1, 0, 0, nullptr, 0);
+  } while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+  if (ret < 1) {
+    // nothing was consumed so the entry can be taken back
+    __atomic_store_n(ring_->sq_tail, tail, __ATOMIC_RELEASE);
+    DFTRACER_LOG_WARN("io_uring submit failed errno=%d, writing directly",
+                      errno);
+    write_at(slot.data.data(), slot.len, slot.offset);
+    slot.busy = false;
+    return;
+  }
+  in_flight_++;
+#endif
+}
+
+// handles the available completions, with wait blocks for at least one
+bool IOUringBackend::reap(bool wait) {
+#ifdef DFTRACER_IO_URING_WRITER
+  while (in_flight_ > 0) {
+    unsigned head = *ring_->cq_head;
+    unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      if (!wait) return true;
+      long ret = syscall(__NR_io_uring_enter, ring_->fd, 0, 1,
+                         IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (ret < 0 && errno != EINTR) {
+        DFTRACER_LOG_ERROR("io_uring wait failed errno=%d", errno);
+        return false;
+      }
+      continue;
+    }
+    for (; head != tail; ++head) {
+      auto cqe = (struct io_uring_cqe *)ring_->cqes + (head & *ring_->cq_mask);
+      Slot &slot = slots_[cqe->user_data];
+      size_t done = cqe->res < 0 ? 0 : cqe->res;
+      if (done < slot.len) {
+        // short or failed writes are finished synchronously
+        write_at(slot.data.data() + done, slot.len - done,
+                 slot.offset + done);
+      }
+      slot.busy = false;
+      in_flight_--;
+    }
+    __atomic_store_n(ring_->cq_head, head, __ATOMIC_RELEASE);
+    return true;
+  }
+#endif
+  return true;
+}
+
+size_t IOUringBackend::write(const char *data, size_t len) {
+  if (ring_ == nullptr) return PwriteBackend::write(data, len);
+  reap(false);
+  size_t index = 0;
+  while (true) {
+    for (index = 0; index < slots_.size() && slots_[index].busy; ++index) {
+    }
+    if (index < slots_.size()) break;
+    if (!reap(true)) {
+      flush();
+      teardown();
+      return PwriteBackend::write(data, len);
+    }
+  }
+  preallocate(offset_ + len);
+  Slot &slot = slots_[index];
+  slot.data.assign(data, data + len);
+  slot.iov.iov_base = slot.data.data();
+  slot.iov.iov_len = len;
+  slot.offset = offset_;
+  slot.len = len;
+  slot.busy = true;
+  offset_ += len;
+  submit(index);
+  return len;
+}
+
+void IOUringBackend::flush() {
+  while (ring_ != nullptr && in_flight_ > 0 && reap(true)) {
+  }
+}
+
+size_t IOUringBackend::size() {
+  flush();
+  return offset_;
+}
+
+int IOUringBackend::close() {
+  flush();
+  teardown();
+  return PwriteBackend::close();
+}
+
+// completions of writes the parent submitted arrive in the parent's ring
+void IOUringBackend::detach() {
+  teardown();
+  for (auto &slot : slots_) slot.busy = false;
+  in_flight_ = 0;
+  PwriteBackend::detach();
+}
+
+MmapBackend::MmapBackend(size_t buffer_size)
+    : PwriteBackend(buffer_size),
+      map_(nullptr),
+      map_start_(0),
+      map_size_(align_up(extent_, sysconf(_SC_PAGESIZE))) {}
+
+bool MmapBackend::open(const char *filename) {
+  if (!open_fd(filename, O_RDWR | O_CREAT | O_CLOEXEC)) return false;
+  if (!map(offset_)) {
+    DFTRACER_LOG_WARN("unable to map %s, using pwrite", filename);
+  }
+  return true;
+}
+
+// maps the extent holding offset, growing the file to cover it
+bool MmapBackend::map(off_t offset) {
+  map_start_ = offset - offset % sysconf(_SC_PAGESIZE);
+  off_t end = map_start_ + map_size_;
+  if (end > allocated_) {
+    if (df_fallocate(fd_, 0, allocated_, end - allocated_) != 0 &&
+        df_ftruncate(fd_, end) != 0) {
+      return false;
+    }
+    allocated_ = end;
+  }
+  void *addr = df_mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd_, map_start_);
+  if (addr == MAP_FAILED) return false;
+  map_ = (char *)addr;
+  return true;
+}
+
+void MmapBackend::unmap() {
+  if (map_ == nullptr) return;
+  df_munmap(map_, map_size_);
+  map_ = nullptr;
+}
+
+void MmapBackend::detach() {
+  unmap();
+  PwriteBackend::detach();
+}
+
+size_t MmapBackend::write(const char *data, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    if (map_ == nullptr) {
+      size_t written = write_at(data + done, len - done, offset_);
+      offset_ += written;
+      return done + written;
+    }
+    size_t pos = offset_ - map_start_;
+    size_t n = std::min(len - done, map_size_ - pos);
+    memcpy(map_ + pos, data + done, n);
+    done += n;
+    offset_ += n;
+    if ((size_t)(offset_ - map_start_) == map_size_) {
+      unmap();
+      map(offset_);
+    }
+  }
+  return len;
+}
+
+int MmapBackend::close() {
+  unmap();
+  return PwriteBackend::close();
+}
+
+bool ShmBackend::open(const char *filename) {
+  DFTRACER_LOG_DEBUG("ShmBackend.open %s", filename);
+  return ring_.create(ring_size_);
+}
+
+size_t ShmBackend::write(const char *data, size_t len) {
+  return ring_.write(data, len);
+}
+
+int ShmBackend::close() {
+  ring_.close();
+  return 0;
+}
+
+std::shared_ptr<WriterBackend> make_writer_backend(WriterBackendType type,
+                                                   size_t buffer_size,
+                                                   size_t ring_size) {
+  switch (type) {
+    case WriterBackendType::WRITER_BACKEND_PWRITE:
+      return std::make_shared<PwriteBackend>(buffer_size);
+    case WriterBackendType::WRITER_BACKEND_DIRECT:
+      return std::make_shared<DirectBackend>(buffer_size);
+    case WriterBackendType::WRITER_BACKEND_IO_URING:
+      return std::make_shared<IOUringBackend>(buffer_size);
+    case WriterBackendType::WRITER_BACKEND_MMAP:
+      return std::make_shared<MmapBackend>(buffer_size);
+    case WriterBackendType::WRITER_BACKEND_SHM:
+      return std::make_shared<ShmBackend>(ring_size);
+    default:
+      return std::make_shared<StdioBackend>(buffer_size);
+  }
+}
+}  // namespace dftracer
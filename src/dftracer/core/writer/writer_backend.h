@@ -0,0 +1,179 @@
+#ifndef DFTRACER_WRITER_BACKEND_H
+#define DFTRACER_WRITER_BACKEND_H
+#include <dftracer/core/buffer/shm_ring.h>
+#include <dftracer/core/common/enumeration.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace dftracer {
+/**
+ * Raw output path of the trace writer. BufferManager hands over whole
+ * chunks that are appended to the file; naming, rotation and staging stay in
+ * STDIOWriter. All backends except stdio use the df_* system calls so the
+ * tracer never traces its own writes.
+ */
+class WriterBackend {
+ public:
+  virtual ~WriterBackend() {}
+  // opens filename for appending, existing content is kept
+  virtual bool open(const char *filename) = 0;
+  // returns the number of bytes accepted
+  virtual size_t write(const char *data, size_t len) = 0;
+  // makes everything written so far visible in the file
+  virtual void flush() = 0;
+  // size of the file once everything written so far has reached it; the
+  // mmap buffer records it as the end of the recoverable trace
+  virtual size_t size() = 0;
+  virtual int close() = 0;
+  // in a forked child: drops what was inherited from the parent without
+  // writing, truncating or closing its file
+  virtual void detach() = 0;
+};
+
+// fopen/fwrite, the original writer
+class StdioBackend : public WriterBackend {
+ public:
+  explicit StdioBackend(size_t buffer_size)
+      : buffer_size_(buffer_size), fh_(nullptr) {}
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  void flush() override;
+  size_t size() override;
+  int close() override;
+  void detach() override;
+
+ private:
+  size_t buffer_size_;
+  FILE *fh_;
+};
+
+// pwrite on a raw descriptor. BufferManager already batches writes so there
+// is no second user space buffer, and the file is grown with fallocate in
+// large extents to keep its blocks contiguous. Unused preallocation is
+// released on close.
+class PwriteBackend : public WriterBackend {
+ public:
+  explicit PwriteBackend(size_t buffer_size);
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  void flush() override {}
+  size_t size() override { return offset_; }
+  int close() override;
+  void detach() override;
+
+ protected:
+  bool open_fd(const char *filename, int flags);
+  void preallocate(size_t end);
+  size_t write_at(const char *data, size_t len, off_t offset);
+
+  int fd_;
+  off_t offset_;
+  off_t allocated_;
+  size_t extent_;
+};
+
+// O_DIRECT writes of whole aligned blocks so the trace does not evict the
+// application's page cache. Data is staged in an aligned buffer; flush and
+// close write the partial last block padded and truncate the file back to
+// its logical size. Falls back to buffered writes on file systems without
+// O_DIRECT support such as tmpfs.
+class DirectBackend : public PwriteBackend {
+ public:
+  explicit DirectBackend(size_t buffer_size);
+  ~DirectBackend() override;
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  void flush() override;
+  size_t size() override;
+  int close() override;
+  void detach() override;
+
+ private:
+  char *stage_;
+  size_t capacity_;
+  size_t staged_;
+};
+
+// io_uring with a small queue of owned buffers: write copies the chunk and
+// returns once it is submitted, completions are reaped when a buffer is
+// needed again. The ring is set up with the raw system calls as liburing is
+// only bound at runtime for tracing. Falls back to pwrite when io_uring is
+// not available.
+class IOUringBackend : public PwriteBackend {
+ public:
+  explicit IOUringBackend(size_t buffer_size);
+  ~IOUringBackend() override;
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  void flush() override;
+  size_t size() override;
+  int close() override;
+  void detach() override;
+
+ private:
+  struct Slot {
+    std::vector<char> data;
+    struct iovec iov;
+    off_t offset;
+    size_t len;
+    bool busy;
+  };
+  struct Ring;
+
+  bool setup();
+  void teardown();
+  void submit(size_t slot);
+  bool reap(bool wait);
+
+  Ring *ring_;
+  std::vector<Slot> slots_;
+  size_t in_flight_;
+};
+
+// copies into a shared mapping of the file that is moved forward one extent
+// at a time; the file is truncated to its logical size on close
+class MmapBackend : public PwriteBackend {
+ public:
+  explicit MmapBackend(size_t buffer_size);
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  int close() override;
+  void detach() override;
+
+ private:
+  bool map(off_t offset);
+  void unmap();
+
+  char *map_;
+  off_t map_start_;
+  size_t map_size_;
+};
+
+// publishes the trace into a shared memory ring drained by
+// dftracer_service, which writes one file per node. open fails when the
+// service is not running so the writer can fall back to a local file.
+class ShmBackend : public WriterBackend {
+ public:
+  explicit ShmBackend(size_t ring_size) : ring_size_(ring_size), ring_() {}
+  bool open(const char *filename) override;
+  size_t write(const char *data, size_t len) override;
+  void flush() override {}
+  size_t size() override { return 0; }
+  int close() override;
+  void detach() override { ring_.detach(); }
+
+ private:
+  size_t ring_size_;
+  ShmRing ring_;
+};
+
+std::shared_ptr<WriterBackend> make_writer_backend(
+    WriterBackendType type, size_t buffer_size,
+    size_t ring_size = 8 * 1024 * 1024);
+}  // namespace dftracer
+#endif  // DFTRACER_WRITER_BACKEND_H
@@ -37,5 +37,7 @@ PYBIND11_MODULE(dftracer_dbg, m) {
             std::unordered_map<std::string, std::tuple<int, float>>());
   m.def("log_metadata_event", &dftracer::log_metadata_event,
         "log metadata event", py::arg("key"), py::arg("value"));
+  m.def("dump_flight_recorder", &dftracer::dump_flight_recorder,
+        "write the flight recorder ring to the trace file");
   m.def("finalize", &dftracer::finalize, "finalize dftracer");
 }
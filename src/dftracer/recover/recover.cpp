@@ -0,0 +1,118 @@
+// Finishes trace files of processes that were killed while running with
+// DFTRACER_MMAP_BUFFER. The events left in <log file>.mmap are cut at the
+// last complete record and appended to the trace file, which is first
+// truncated to the size it had after its last complete write.
+#include <dftracer/core/buffer/mmap_buffer.h>
+#include <dftracer/core/compression/zlib_compression.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static bool write_all(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written <= 0) return false;
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+static int recover(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    std::cerr << "Unable to open " << path << ": " << strerror(errno)
+              << std::endl;
+    return 1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < dftracer::MMAP_BUFFER_HEADER_SIZE) {
+    std::cerr << path << " is not a dftracer mmap buffer." << std::endl;
+    close(fd);
+    return 1;
+  }
+  void* region = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (region == MAP_FAILED) {
+    std::cerr << "Unable to map " << path << ": " << strerror(errno)
+              << std::endl;
+    return 1;
+  }
+  auto header = static_cast<const dftracer::MmapBufferHeader*>(region);
+  if (memcmp(header->magic, DFT_MMAP_BUFFER_MAGIC,
+             sizeof(DFT_MMAP_BUFFER_MAGIC)) != 0 ||
+      header->version != DFT_MMAP_BUFFER_VERSION) {
+    std::cerr << path << " is not a dftracer mmap buffer." << std::endl;
+    munmap(region, st.st_size);
+    return 1;
+  }
+  const char* data =
+      static_cast<const char*>(region) + dftracer::MMAP_BUFFER_HEADER_SIZE;
+  size_t available = st.st_size - dftracer::MMAP_BUFFER_HEADER_SIZE;
+  size_t committed = header->committed;
+  if (committed > header->capacity) committed = header->capacity;
+  if (committed > available) committed = available;
+  // drop a record cut by the kill
+  while (committed > 0 && data[committed - 1] != '\n') committed--;
+  std::string trace_file = header->trace_file;
+
+  int status = 0;
+  if (header->trace_size == 0 && committed == 0) {
+    std::cout << path << " holds no events." << std::endl;
+  } else {
+    int trace_fd = open(trace_file.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (trace_fd == -1 || ftruncate(trace_fd, header->trace_size) != 0 ||
+        lseek(trace_fd, 0, SEEK_END) == -1) {
+      std::cerr << "Unable to update " << trace_file << ": "
+                << strerror(errno) << std::endl;
+      status = 1;
+    } else {
+      std::vector<char> tail(data, data + committed);
+      tail.push_back(']');
+      bool ok;
+      if (header->compression) {
+        dftracer::ZlibCompression compressor;
+        compressor.initialize(tail.size());
+        std::vector<char> out(compressor.chunk_size());
+        size_t size = compressor.compress(tail.data(), tail.size(), out.data());
+        compressor.finalize();
+        ok = size > 0 && write_all(trace_fd, out.data(), size);
+      } else {
+        ok = write_all(trace_fd, tail.data(), tail.size());
+      }
+      if (!ok || fsync(trace_fd) != 0) {
+        std::cerr << "Unable to write " << trace_file << ": "
+                  << strerror(errno) << std::endl;
+        status = 1;
+      } else {
+        std::cout << "Recovered " << committed << " bytes of events into "
+                  << trace_file << "." << std::endl;
+      }
+    }
+    if (trace_fd != -1) close(trace_fd);
+  }
+  munmap(region, st.st_size);
+  if (status == 0) unlink(path.c_str());
+  return status;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <log file>" DFT_MMAP_BUFFER_SUFFIX
+              << "..." << std::endl;
+    return 1;
+  }
+  int status = 0;
+  for (int i = 1; i < argc; ++i) {
+    status |= recover(argv[i]);
+  }
+  return status;
+}
@@ -1,6 +1,7 @@
 #ifndef DFTRACER_SERVER
 #define DFTRACER_SERVER
 
+#include <dftracer/core/buffer/shm_ring.h>
 #include <dftracer/core/common/cpp_typedefs.h>
 #include <dftracer/core/common/datastructure.h>
 #include <dftracer/core/common/logging.h>
@@ -8,6 +9,7 @@
 #include <dftracer/core/df_logger.h>
 #include <dftracer/core/utils/configuration_manager.h>
 #include <dftracer/service/common/datastructure.h>
+#include <dirent.h>
 
 #include <atomic>
 #include <chrono>
@@ -32,6 +34,10 @@ class DFTracerService {
     conf->enable = true;
     conf->compression = false;
     conf->write_buffer_size = 16 * 1024 * 1024;
+    // the service is where shared memory rings end up
+    if (conf->writer_backend == WriterBackendType::WRITER_BACKEND_SHM) {
+      conf->writer_backend = WriterBackendType::WRITER_BACKEND_STDIO;
+    }
     interval = conf->trace_interval_ms;
     if (conf->log_file.empty()) {
       throw std::runtime_error(
@@ -70,16 +76,25 @@ class DFTracerService {
   // Destructor: ensures the service is stopped and resources are cleaned up
   ~DFTracerService() { stop(); }
 
-  // Starts the background worker thread for periodic metric collection
+  // Starts the background worker thread for periodic metric collection and
+  // the thread draining the shared memory rings of traced processes
   void start() {
     running = true;
     worker = std::thread([this]() { this->progressEngine(); });
+    if (!ShmRing::publish_service()) {
+      fprintf(stderr, "Warning: unable to announce the service, traced "
+                      "processes will write their own files\n");
+    }
+    drainer = std::thread([this]() { this->drainEngine(); });
   }
 
-  // Stops the worker thread and finalizes the buffer manager
+  // Stops the worker threads and finalizes the buffer manager
   void stop() {
     running = false;
+    // processes starting from now on fall back to their own files
+    ShmRing::withdraw_service();
     if (worker.joinable()) worker.join();
+    if (drainer.joinable()) drainer.join();
     this->buffer_manager->finalize(index.load(std::memory_order_relaxed), true);
     if (auto conf =
             dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
@@ -102,6 +117,94 @@ class DFTracerService {
   std::thread worker;         // Worker thread for metric collection
   std::mutex data_mutex;      // Mutex for thread safety (not used here)
   std::shared_ptr<dftracer::BufferManager> buffer_manager;  // Buffer manager
+  std::thread drainer;  // Worker thread for the shared memory rings
+
+  // Shared memory ring of one traced process and its incomplete last line
+  struct RingStream {
+    std::unique_ptr<ShmRing> ring;
+    std::string partial;
+    bool started = false;
+  };
+  std::map<std::string, RingStream> rings;  // Only used by drainer
+
+  // Main loop moving events from traced processes into the node trace
+  void drainEngine() {
+    auto last_scan = std::chrono::steady_clock::time_point();
+    while (running) {
+      auto now = std::chrono::steady_clock::now();
+      if (now - last_scan >= std::chrono::milliseconds(100)) {
+        scanRings();
+        last_scan = now;
+      }
+      if (drainRings(false) == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    scanRings();
+    drainRings(true);
+  }
+
+  // Attaches the rings created since the last scan
+  void scanRings() {
+    std::string prefix =
+        DFT_SHM_RING_PREFIX + std::to_string(getuid()) + std::string(".");
+    DIR* dir = opendir(DFT_SHM_DIR);
+    if (!dir) return;
+    while (struct dirent* entry = readdir(dir)) {
+      std::string name(entry->d_name);
+      if (name.compare(0, prefix.size(), prefix) != 0 || rings.count(name)) {
+        continue;
+      }
+      RingStream stream;
+      stream.ring = std::make_unique<ShmRing>();
+      if (stream.ring->attach(name)) rings.emplace(name, std::move(stream));
+    }
+    closedir(dir);
+  }
+
+  // Appends the complete lines of every ring to the node trace and removes
+  // finished rings, returns the number of bytes drained
+  size_t drainRings(bool last) {
+    size_t total = 0;
+    for (auto it = rings.begin(); it != rings.end();) {
+      RingStream& stream = it->second;
+      total += stream.ring->read(stream.partial);
+      // each process stream starts with the opening bracket of its trace
+      if (!stream.started && !stream.partial.empty()) {
+        if (stream.partial[0] != '[') {
+          stream.started = true;
+        } else if (stream.partial.size() > 1) {
+          stream.partial.erase(0, stream.partial[1] == '\n' ? 2 : 1);
+          stream.started = true;
+        }
+      }
+      size_t end = stream.partial.rfind('\n');
+      if (stream.started && end != std::string::npos) {
+        buffer_manager->log_lines(stream.partial.data(), end + 1);
+        stream.partial.erase(0, end + 1);
+      }
+      bool finished = stream.ring->finished();
+      if (finished || last) {
+        // what is left is the closing bracket or a line cut short
+        if (stream.ring->dropped() > 0 ||
+            (!stream.partial.empty() && stream.partial != "]")) {
+          fprintf(stderr, "Warning: process %d lost %lu bytes of events\n",
+                  stream.ring->pid(),
+                  (unsigned long)(stream.ring->dropped() +
+                                  stream.partial.size()));
+        }
+        if (finished) {
+          stream.ring->release();
+        } else {
+          stream.ring->detach();
+        }
+        it = rings.erase(it);
+        continue;
+      }
+      ++it;
+    }
+    return total;
+  }
 
   // Main loop for periodic metric collection
   void progressEngine() {
@@ -0,0 +1,57 @@
+// Writes a file with REQUESTS one byte aio_writes, reads it back with
+// REQUESTS one byte aio_reads and once more with a single lio_listio of
+// REQUESTS reads. Every request is waited for and collected with
+// aio_return, so that each is traced once as an aio_*_async event.
+//
+// usage: aio DATA_DIR [REQUESTS]
+
+#include <aio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+static bool wait_for(struct aiocb *cb) {
+  const struct aiocb *list[1] = {cb};
+  while (aio_error(cb) == EINPROGRESS) aio_suspend(list, 1, NULL);
+  return aio_return(cb) == 1;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int requests = argc > 2 ? atoi(argv[2]) : 16;
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_aio.dat", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  std::vector<char> data(requests, 'x');
+  std::vector<struct aiocb> cbs(requests);
+  for (int i = 0; i < requests; ++i) {
+    struct aiocb &cb = cbs[i];
+    memset(&cb, 0, sizeof(cb));
+    cb.aio_fildes = fd;
+    cb.aio_buf = &data[i];
+    cb.aio_nbytes = 1;
+    cb.aio_offset = i;
+    if (aio_write(&cb) != 0 || !wait_for(&cb)) return 1;
+  }
+  for (int i = 0; i < requests; ++i) {
+    if (aio_read(&cbs[i]) != 0 || !wait_for(&cbs[i])) return 1;
+  }
+  std::vector<struct aiocb *> list(requests);
+  for (int i = 0; i < requests; ++i) {
+    cbs[i].aio_lio_opcode = LIO_READ;
+    list[i] = &cbs[i];
+  }
+  if (lio_listio(LIO_WAIT, list.data(), requests, NULL) != 0) return 1;
+  for (int i = 0; i < requests; ++i) {
+    if (aio_return(&cbs[i]) != 1) return 1;
+  }
+  close(fd);
+  unlink(filename);
+  return 0;
+}
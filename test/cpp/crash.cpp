@@ -0,0 +1,27 @@
+// Writes to a file and kills itself with SIGKILL before the tracer can
+// finish its trace, leaving the events in the DFTRACER_MMAP_BUFFER file for
+// dftracer_recover.
+//
+// usage: crash DATA_DIR [WRITES]
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int writes = argc > 2 ? atoi(argv[2]) : 64;
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_crash.dat", argv[1]);
+  int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  for (int i = 0; i < writes; ++i) {
+    if (write(fd, "x", 1) != 1) return 1;
+  }
+  close(fd);
+  unlink(filename);
+  raise(SIGKILL);
+  return 1;
+}
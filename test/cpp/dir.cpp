@@ -0,0 +1,38 @@
+// Creates FILES empty files in a new directory under DATA_DIR and lists it
+// once with opendir, readdir and closedir, so that the directory scan
+// summary can be checked against exact counts. The listing has FILES + 2
+// entries with . and .., read with FILES + 3 readdirs.
+//
+// usage: dir DATA_DIR [FILES]
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int files = argc > 2 ? atoi(argv[2]) : 8;
+  char dirname[1024], filename[1100];
+  snprintf(dirname, sizeof(dirname), "%s/demodir", argv[1]);
+  if (mkdir(dirname, 0755) != 0) return 1;
+  for (int i = 0; i < files; ++i) {
+    snprintf(filename, sizeof(filename), "%s/file_%d", dirname, i);
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return 1;
+    close(fd);
+  }
+  DIR *dirp = opendir(dirname);
+  if (dirp == NULL) return 1;
+  int entries = 0;
+  while (readdir(dirp) != NULL) entries++;
+  if (closedir(dirp) != 0 || entries != files + 2) return 1;
+  for (int i = 0; i < files; ++i) {
+    snprintf(filename, sizeof(filename), "%s/file_%d", dirname, i);
+    unlink(filename);
+  }
+  rmdir(dirname);
+  return 0;
+}
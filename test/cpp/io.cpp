@@ -0,0 +1,35 @@
+// Writes a file with WRITES sequential one byte writes and reads it back
+// with READS one byte reads, so that the traces of the tracer features can
+// be checked against exact call counts. Besides the reads and writes it
+// makes two opens, two closes and one unlink on the file. READS may not
+// exceed WRITES.
+//
+// usage: io DATA_DIR [WRITES] [READS]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int writes = argc > 2 ? atoi(argv[2]) : 64;
+  int reads = argc > 3 ? atoi(argv[3]) : 64;
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_io.dat", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  for (int i = 0; i < writes; ++i) {
+    if (write(fd, "x", 1) != 1) return 1;
+  }
+  close(fd);
+  fd = open(filename, O_RDONLY);
+  if (fd == -1) return 1;
+  char c;
+  for (int i = 0; i < reads; ++i) {
+    if (read(fd, &c, 1) != 1) return 1;
+  }
+  close(fd);
+  unlink(filename);
+  return 0;
+}
@@ -0,0 +1,89 @@
+// Writes and reads back a file through liburing the way double buffered
+// applications do: the next batch is submitted before the CQEs of the one
+// before are marked seen, and tags are reused across batches. Every request
+// must be traced exactly once with the result of its own CQE.
+//
+// usage: io_uring DATA_DIR [BATCHES]
+
+#include <fcntl.h>
+#include <liburing.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEPTH 16
+#define BATCH 4
+#define BLOCK 4096
+
+static char buffer[BATCH][BLOCK];
+
+// alternates so a CQE matched to the request of another batch shows up as a
+// result that differs from the requested count
+static unsigned batch_len(int batch) { return batch % 2 ? BLOCK / 2 : BLOCK; }
+
+static int queue(struct io_uring *ring, int fd, int batch, bool write) {
+  for (int i = 0; i < BATCH; ++i) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (sqe == nullptr) return -1;
+    off_t offset = (off_t)(batch * BATCH + i) * BLOCK;
+    if (write) {
+      io_uring_prep_write(sqe, fd, buffer[i], batch_len(batch), offset);
+    } else {
+      io_uring_prep_read(sqe, fd, buffer[i], batch_len(batch), offset);
+    }
+    io_uring_sqe_set_data(sqe, (void *)(uintptr_t)i);
+  }
+  return 0;
+}
+
+static int complete(struct io_uring *ring, int batch, unsigned count) {
+  for (unsigned i = 0; i < count; ++i) {
+    struct io_uring_cqe *cqe;
+    if (io_uring_wait_cqe(ring, &cqe) != 0) return -1;
+    if (cqe->res < 0) {
+      fprintf(stderr, "batch %d failed with %d\n", batch, cqe->res);
+      return -1;
+    }
+    io_uring_cqe_seen(ring, cqe);
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int batches = argc > 2 ? atoi(argv[2]) : 16;
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_io_uring.dat", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  memset(buffer, 'x', sizeof(buffer));
+  struct io_uring ring;
+  if (io_uring_queue_init(DEPTH, &ring, 0) != 0) return 1;
+
+  struct __kernel_timespec poll = {0, 0};
+  for (int batch = 0; batch < batches; ++batch) {
+    if (queue(&ring, fd, batch, true) != 0) return 1;
+    // peeks while the batch is queued but not yet submitted
+    struct io_uring_cqe *cqe;
+    io_uring_wait_cqe_timeout(&ring, &cqe, &poll);
+    if (io_uring_submit(&ring) < 0) return 1;
+    if (batch > 0 && complete(&ring, batch - 1, BATCH) != 0) return 1;
+  }
+  if (complete(&ring, batches - 1, BATCH) != 0) return 1;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    if (queue(&ring, fd, batch, false) != 0) return 1;
+    if (io_uring_submit_and_wait(&ring, BATCH) < 0) return 1;
+    struct io_uring_cqe *cqes[BATCH];
+    unsigned count = io_uring_peek_batch_cqe(&ring, cqes, BATCH);
+    io_uring_cq_advance(&ring, count);
+    if (complete(&ring, batch, BATCH - count) != 0) return 1;
+  }
+
+  io_uring_queue_exit(&ring);
+  close(fd);
+  unlink(filename);
+  return 0;
+}
@@ -0,0 +1,40 @@
+// Maps a file of 16 pages and syncs and unmaps it after an anonymous
+// MAP_FIXED mapping replaced its upper half, so that the traces can be
+// checked for which calls are attributed to the file. Of the mapping calls
+// one mmap, one madvise, two msyncs and one munmap are on the file.
+//
+// usage: mmap DATA_DIR
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t half = 8 * page;
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_mmap.dat", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  if (ftruncate(fd, 2 * half) != 0) return 1;
+  char *data = (char *)mmap(NULL, 2 * half, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) return 1;
+  memset(data, 'x', 2 * half);
+  if (msync(data, 2 * half, MS_SYNC) != 0) return 1;
+  if (madvise(data, half, MADV_WILLNEED) != 0) return 1;
+  // the upper half is no longer the file
+  void *anon = mmap(data + half, half, PROT_READ | PROT_WRITE,
+                    MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (anon == MAP_FAILED) return 1;
+  if (msync(anon, half, MS_SYNC) != 0) return 1;
+  if (munmap(anon, half) != 0) return 1;
+  if (msync(data, half, MS_SYNC) != 0) return 1;
+  if (munmap(data, half) != 0) return 1;
+  close(fd);
+  unlink(filename);
+  return 0;
+}
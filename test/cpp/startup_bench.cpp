@@ -0,0 +1,115 @@
+// Startup latency of processes under libdftracer_preload. Launches COUNT
+// short lived processes with posix_spawn and waits for each, once without
+// the tracer, once with it parsing its configuration and once loading the
+// DFTRACER_CONFIG_SNAPSHOT this process publishes, and reports the time per
+// launch. The configuration is taken from the environment as usual. Fails
+// if the published snapshot is not accepted when it is loaded again.
+//
+// usage: startup_bench PRELOAD [COUNT] [COMMAND [ARG...]]
+
+#include <dftracer/core/common/constants.h>
+#include <dftracer/core/common/singleton.h>
+#include <dftracer/core/utils/configuration_manager.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern char **environ;
+
+static bool has_name(const char *entry, const char *name) {
+  size_t len = strlen(name);
+  return strncmp(entry, name, len) == 0 && entry[len] == '=';
+}
+
+// environ without LD_PRELOAD and the snapshot, plus the given entries
+static std::vector<std::string> make_env(
+    const std::vector<std::string> &extra) {
+  std::vector<std::string> env;
+  for (char **entry = environ; *entry != nullptr; ++entry) {
+    if (has_name(*entry, "LD_PRELOAD") ||
+        has_name(*entry, DFTRACER_CONFIG_SNAPSHOT)) {
+      continue;
+    }
+    env.push_back(*entry);
+  }
+  env.insert(env.end(), extra.begin(), extra.end());
+  return env;
+}
+
+// microseconds per launch, sorted; empty if a launch failed
+static std::vector<double> launch(char *const argv[],
+                                  std::vector<std::string> env, int count) {
+  std::vector<char *> envp;
+  for (auto &entry : env) envp.push_back(&entry[0]);
+  envp.push_back(nullptr);
+  std::vector<double> times;
+  for (int i = 0; i < count; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int status = 0;
+    if (posix_spawn(&pid, argv[0], nullptr, nullptr, argv, envp.data()) != 0 ||
+        waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "%s failed with status %d\n", argv[0], status);
+      return {};
+    }
+    times.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  }
+  std::sort(times.begin(), times.end());
+  return times;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s PRELOAD [COUNT] [COMMAND [ARG...]]\n", argv[0]);
+    return 1;
+  }
+  std::string preload = std::string("LD_PRELOAD=") + argv[1];
+  int count = argc > 2 ? atoi(argv[2]) : 200;
+  char *default_command[] = {(char *)"/bin/true", nullptr};
+  char *const *command = argc > 3 ? argv + 3 : default_command;
+
+  // parses the configuration and publishes the snapshot into environ
+  auto conf =
+      dftracer::Singleton<dftracer::ConfigurationManager>::get_instance();
+  const char *snapshot = getenv(DFTRACER_CONFIG_SNAPSHOT);
+  if (!conf->enable || snapshot == nullptr) {
+    fprintf(stderr, "set DFTRACER_ENABLE=1 to publish a snapshot\n");
+    return 1;
+  }
+  std::string snapshot_entry =
+      std::string(DFTRACER_CONFIG_SNAPSHOT) + "=" + snapshot;
+  // a rejected snapshot would silently time the parse twice
+  dftracer::ConfigurationManager check;
+  if (!check.from_snapshot) {
+    fprintf(stderr, "the published snapshot is not accepted\n");
+    return 1;
+  }
+
+  struct Mode {
+    const char *name;
+    std::vector<std::string> extra;
+  };
+  std::vector<Mode> modes = {{"untraced", {}},
+                             {"parse", {preload}},
+                             {"snapshot", {preload, snapshot_entry}}};
+  printf("%-10s %10s %10s %10s\n", "mode", "mean us", "p50 us", "p99 us");
+  for (auto &mode : modes) {
+    auto times = launch(command, make_env(mode.extra), count);
+    if (times.empty()) return 1;
+    double sum = 0;
+    for (auto time : times) sum += time;
+    printf("%-10s %10.1f %10.1f %10.1f\n", mode.name, sum / times.size(),
+           times[times.size() / 2], times[times.size() * 99 / 100]);
+  }
+  return 0;
+}
@@ -0,0 +1,42 @@
+// Exercises the stat family as exported by the system glibc. With glibc 2.33
+// and newer stat/fstat/lstat are real symbols instead of __xstat wrappers.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  char filename[1024];
+  sprintf(filename, "%s/demofile_stat.txt", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (fd == -1) return 1;
+  struct stat st;
+  stat(filename, &st);
+  lstat(filename, &st);
+  fstat(fd, &st);
+  fstatat(AT_FDCWD, filename, &st, 0);
+  fstatat(fd, "", &st, AT_EMPTY_PATH);
+  struct stat64 st64;
+  stat64(filename, &st64);
+  lstat64(filename, &st64);
+  fstat64(fd, &st64);
+  fstatat64(AT_FDCWD, filename, &st64, 0);
+  int dd = open(argv[1], O_RDONLY | O_DIRECTORY);
+  if (dd != -1) {
+    fstatat(dd, "demofile_stat.txt", &st, 0);
+#ifdef STATX_BASIC_STATS
+    struct statx stx;
+    statx(dd, "demofile_stat.txt", 0, STATX_BASIC_STATS, &stx);
+#endif
+    close(dd);
+  }
+#ifdef STATX_BASIC_STATS
+  struct statx stx;
+  statx(AT_FDCWD, filename, 0, STATX_SIZE, &stx);
+#endif
+  close(fd);
+  unlink(filename);
+  return 0;
+}
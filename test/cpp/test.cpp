@@ -2,12 +2,17 @@
 // Created by hariharan on 8/8/22.
 //
 
+#include <aio.h>
 #include <assert.h>
 #include <dftracer/dftracer.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <utime.h>
 
@@ -79,6 +84,17 @@ int main(int argc, char *argv[]) {
   fd = openat(dd, "demofile2.txt", O_WRONLY | O_CREAT, 777);
   if (fd != -1) close(fd);
   close(dd);
+  DIR *dirp = opendir(dir);
+  if (dirp != nullptr) {
+    while (readdir(dirp) != nullptr);
+    closedir(dirp);
+  }
+  dd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (dd != -1) {
+    char dents[4096];
+    while (getdents64(dd, dents, sizeof(dents)) > 0);
+    close(dd);
+  }
   sprintf(filename, "%s/demofile2.txt", argv[1]);
   fd = creat64(filename, O_RDWR);
   if (fd != -1) close(fd);
@@ -86,10 +102,45 @@ int main(int argc, char *argv[]) {
   int set_offset = lseek(fd, 1, SEEK_SET);
   (void)set_offset;
   char buf[1];
+  posix_fadvise(fd, 0, 2, POSIX_FADV_WILLNEED);
+  readahead(fd, 0, 2);
   pread(fd, buf, 1, 1);
   pread64(fd, buf, 1, 1);
   pwrite(fd, buf, 1, 1);
   pwrite64(fd, buf, 1, 1);
+  struct iovec iov[2] = {{buf, 1}, {buf, 1}};
+  writev(fd, iov, 2);
+  readv(fd, iov, 2);
+  pwritev2(fd, iov, 2, 0, 0);
+  preadv2(fd, iov, 2, 0, 0);
+  char filename_copy[1024];
+  sprintf(filename_copy, "%s/demofile3.txt", argv[1]);
+  int fd_copy = open(filename_copy, O_RDWR | O_CREAT, 0644);
+  if (fd_copy != -1) {
+    off64_t off_in = 0;
+    copy_file_range(fd, &off_in, fd_copy, nullptr, 2, 0);
+    off_t off_send = 0;
+    sendfile(fd_copy, fd, &off_send, 2);
+    close(fd_copy);
+  }
+  remove(filename_copy);
+  struct aiocb cb;
+  memset(&cb, 0, sizeof(cb));
+  cb.aio_fildes = fd;
+  cb.aio_buf = buf;
+  cb.aio_nbytes = 1;
+  if (aio_read(&cb) == 0) {
+    const struct aiocb *cb_list[1] = {&cb};
+    aio_suspend(cb_list, 1, nullptr);
+    aio_error(&cb);
+    aio_return(&cb);
+  }
+  void *map = mmap(nullptr, 2, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map != MAP_FAILED) {
+    madvise(map, 2, MADV_SEQUENTIAL);
+    msync(map, 2, MS_SYNC);
+    munmap(map, 2);
+  }
   fsync(fd);
   fdatasync(fd);
   readlinkat(fd, filename, buf, 1);
@@ -0,0 +1,51 @@
+// Writes a file with CALLS writevs of two one byte buffers, reads it back
+// with CALLS readvs and CALLS preadvs of the same shape and copies it into a
+// second file with CALLS two byte copy_file_ranges and then CALLS two byte
+// sendfiles, so that the vector and copy calls can be checked against exact
+// counts. Both files are in DATA_DIR and are traced.
+//
+// usage: vector_io DATA_DIR [CALLS]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) return 1;
+  int calls = argc > 2 ? atoi(argv[2]) : 16;
+  char filename[1024], copyname[1024];
+  snprintf(filename, sizeof(filename), "%s/demofile_vector.dat", argv[1]);
+  snprintf(copyname, sizeof(copyname), "%s/demofile_vector.copy", argv[1]);
+  int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return 1;
+  char a = 'a', b = 'b';
+  struct iovec iov[2] = {{&a, 1}, {&b, 1}};
+  for (int i = 0; i < calls; ++i) {
+    if (writev(fd, iov, 2) != 2) return 1;
+  }
+  if (lseek(fd, 0, SEEK_SET) != 0) return 1;
+  for (int i = 0; i < calls; ++i) {
+    if (readv(fd, iov, 2) != 2) return 1;
+  }
+  for (int i = 0; i < calls; ++i) {
+    if (preadv(fd, iov, 2, 2 * i) != 2) return 1;
+  }
+  int out = open(copyname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out == -1) return 1;
+  off64_t in_offset = 0;
+  for (int i = 0; i < calls; ++i) {
+    if (copy_file_range(fd, &in_offset, out, NULL, 2, 0) != 2) return 1;
+  }
+  off_t offset = 0;
+  for (int i = 0; i < calls; ++i) {
+    if (sendfile(out, fd, &offset, 2) != 2) return 1;
+  }
+  close(out);
+  close(fd);
+  unlink(copyname);
+  unlink(filename);
+  return 0;
+}
@@ -0,0 +1,93 @@
+// Write throughput of the trace writer backends. Each backend appends
+// SIZE_MB of JSON lines in CHUNK_KB chunks, the way BufferManager hands over
+// its buffer, and reports the rate with and without close as well as how
+// much of the file is left in the page cache.
+//
+// usage: writer_bench DIR [SIZE_MB] [CHUNK_KB] [BACKEND...]
+
+#include <dftracer/core/writer/writer_backend.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double cached_percent(const char *filename, size_t size) {
+  if (size == 0) return 0;
+  FILE *fh = fopen(filename, "r");
+  if (fh == nullptr) return 0;
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(fh), 0);
+  fclose(fh);
+  if (addr == MAP_FAILED) return 0;
+  size_t page = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> pages((size + page - 1) / page);
+  size_t resident = 0;
+  if (mincore(addr, size, pages.data()) == 0) {
+    for (auto p : pages) resident += p & 1;
+  }
+  munmap(addr, size);
+  return 100.0 * resident / pages.size();
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s DIR [SIZE_MB] [CHUNK_KB] [BACKEND...]\n",
+            argv[0]);
+    return 1;
+  }
+  size_t total = (argc > 2 ? atol(argv[2]) : 256) * 1024 * 1024;
+  size_t chunk_size = (argc > 3 ? atol(argv[3]) : 1024) * 1024;
+  std::vector<std::string> names;
+  for (int i = 4; i < argc; ++i) names.push_back(argv[i]);
+  if (names.empty()) names = {"STDIO", "PWRITE", "DIRECT", "IO_URING", "MMAP"};
+
+  std::string chunk;
+  const char *line =
+      "{\"id\":1,\"name\":\"read\",\"cat\":\"POSIX\",\"pid\":1,\"tid\":1,"
+      "\"ts\":1700000000000000,\"dur\":12,\"ph\":\"X\",\"args\":{}}\n";
+  while (chunk.size() < chunk_size) chunk += line;
+  chunk.resize(chunk_size);
+
+  int status = 0;
+  printf("%-10s %12s %12s %10s\n", "backend", "write MB/s", "close MB/s",
+         "cached %");
+  for (auto &name : names) {
+    WriterBackendType type;
+    convert(name, type);
+    std::string filename =
+        std::string(argv[1]) + "/writer_bench_" + name + ".pfw";
+    unlink(filename.c_str());
+    auto backend = dftracer::make_writer_backend(type, chunk_size);
+    if (!backend->open(filename.c_str())) {
+      fprintf(stderr, "unable to open %s\n", filename.c_str());
+      return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t written = 0;
+    while (written < total) {
+      written += backend->write(chunk.data(), chunk.size());
+    }
+    backend->flush();
+    auto flushed = std::chrono::steady_clock::now();
+    backend->close();
+    auto closed = std::chrono::steady_clock::now();
+    double mb = written / (1024.0 * 1024.0);
+    std::chrono::duration<double> t_write = flushed - start;
+    std::chrono::duration<double> t_close = closed - start;
+    struct stat st;
+    st.st_size = 0;
+    if (stat(filename.c_str(), &st) != 0 || (size_t)st.st_size != written) {
+      fprintf(stderr, "%s wrote %zu bytes, file has %ld\n", name.c_str(),
+              written, (long)st.st_size);
+      status = 1;
+    }
+    printf("%-10s %12.1f %12.1f %10.1f\n", name.c_str(), mb / t_write.count(),
+           mb / t_close.count(), cached_percent(filename.c_str(), written));
+    unlink(filename.c_str());
+  }
+  return status;
+}
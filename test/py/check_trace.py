@@ -0,0 +1,178 @@
+import argparse
+import glob
+import gzip
+import json
+import os
+import struct
+import subprocess
+
+# Verifies the content of the traces of a test run, e.g.
+#   check_trace.py LOG_FILE --count io_uring_read=64 --same io_uring_read=ret,count
+# Each option may be given more than once. NAME matches the name or the
+# category of an event, "*" matches every event.
+
+parser = argparse.ArgumentParser(prog="DFTracer trace check")
+parser.add_argument("log_file", type=str,
+                    help="DFTRACER_LOG_FILE of the traced run")
+parser.add_argument("--count", action="append", default=[],
+                    metavar="NAME=N", help="exactly N complete events NAME")
+parser.add_argument("--at-most", action="append", default=[],
+                    metavar="NAME=N", help="at most N complete events NAME")
+parser.add_argument("--args", action="append", default=[],
+                    metavar="NAME=KEY[,KEY]",
+                    help="every complete event NAME has these args")
+parser.add_argument("--same", action="append", default=[],
+                    metavar="NAME=KEY,KEY",
+                    help="the two args are equal in every complete event NAME")
+parser.add_argument("--sum", action="append", default=[],
+                    metavar="NAME=KEY=N",
+                    help="the arg KEY of the complete and counter events NAME "
+                         "adds up to N, an event without it counts as one")
+parser.add_argument("--metadata", action="append", default=[],
+                    metavar="NAME",
+                    help="a metadata event carries the custom metadata NAME")
+parser.add_argument("--absent", action="append", default=[],
+                    metavar="PATTERN", help="no file matches PATTERN")
+parser.add_argument("--none", action="store_true",
+                    help="the run left no trace at all")
+parser.add_argument("--recover", type=str, metavar="DFTRACER_RECOVER",
+                    help="first finish the traces from their mmap buffers, "
+                         "which must exist")
+parser.add_argument("--complete", action="store_true",
+                    help="every trace ends with the closing ]")
+parser.add_argument("--segments", type=int, default=0, metavar="N",
+                    help="at least N trace files, each with its own header, "
+                         "hostname and file hash metadata and footer")
+args = parser.parse_args()
+
+
+def read_text(filename):
+    opener = gzip.open if filename.endswith(".gz") else open
+    with opener(filename, "rt") as trace:
+        return trace.read()
+
+
+def read_events(filename):
+    for line in read_text(filename).splitlines():
+        line = line.strip()
+        if line in ("", "[", "]"):
+            continue
+        yield json.loads(line)
+
+
+def split(option):
+    name, _, value = option.partition("=")
+    if not name or not value:
+        raise SystemExit(f"expected NAME=VALUE, got {option}")
+    return name, value
+
+
+def named(events, name):
+    return [event for event in events
+            if name in ("*", event.get("name"), event.get("cat"))]
+
+
+# a rotated segment must be readable on its own
+def check_segment(filename):
+    text = read_text(filename).strip()
+    if not text.startswith("[") or not text.endswith("]"):
+        raise SystemExit(f"{filename} lacks its header or footer")
+    metadata = {event.get("name") for event in read_events(filename)
+                if event.get("ph") == "M"}
+    missing = {"HH", "FH"} - metadata
+    if missing:
+        raise SystemExit(f"{filename} lacks {missing} metadata")
+
+
+def recover():
+    buffers = glob.glob(f"{args.log_file}*.mmap")
+    if not buffers:
+        raise SystemExit(f"no mmap buffers for {args.log_file}")
+    for path in buffers:
+        # MmapBufferHeader: magic[8], version, compression, capacity,
+        # committed
+        with open(path, "rb") as buffer:
+            committed = struct.unpack_from("<Q", buffer.read(32), 24)[0]
+        if committed == 0:
+            raise SystemExit(f"{path} holds no committed events")
+    subprocess.run([args.recover] + buffers, check=True)
+    left = [path for path in buffers if os.path.exists(path)]
+    if left:
+        raise SystemExit(f"{left} not removed after recovery")
+
+
+def main():
+    if args.recover:
+        recover()
+    files = glob.glob(f"{args.log_file}*.pfw*")
+    files = [filename for filename in files
+             if not filename.endswith(".mmap")]
+    if args.none:
+        if files:
+            raise SystemExit(f"{files} left behind")
+        return
+    if not files:
+        raise SystemExit(f"no traces for {args.log_file}")
+    if len(files) < args.segments:
+        raise SystemExit(f"expected {args.segments} segments, "
+                         f"found {len(files)}")
+    events = []
+    for filename in files:
+        if args.complete and not read_text(filename).rstrip().endswith("]"):
+            raise SystemExit(f"{filename} does not end with ]")
+        if args.segments:
+            check_segment(filename)
+        events.extend(read_events(filename))
+    complete = [event for event in events if event.get("ph") == "X"]
+    counters = [event for event in events if event.get("ph") == "C"]
+    metadata = [event for event in events if event.get("ph") == "M"]
+    for option in args.count:
+        name, value = split(option)
+        found = len(named(complete, name))
+        if found != int(value):
+            raise SystemExit(f"expected {value} {name} events, found {found}")
+    for option in args.at_most:
+        name, value = split(option)
+        found = len(named(complete, name))
+        if found > int(value):
+            raise SystemExit(f"expected at most {value} {name} events, "
+                             f"found {found}")
+    for option in args.args:
+        name, value = split(option)
+        for event in named(complete, name):
+            missing = [key for key in value.split(",")
+                       if key not in event.get("args", {})]
+            if missing:
+                raise SystemExit(f"{name} event without {missing}: {event}")
+    for option in args.same:
+        name, value = split(option)
+        first, second = value.split(",")
+        for event in named(complete, name):
+            event_args = event.get("args", {})
+            if event_args.get(first) != event_args.get(second):
+                raise SystemExit(f"{name} event with {first} != {second}: "
+                                 f"{event}")
+    for option in args.sum:
+        name, value = split(option)
+        key, total = split(value)
+        found = sum(float(event.get("args", {}).get(key, 1))
+                    for event in named(complete + counters, name))
+        if abs(found - float(total)) > 1e-6:
+            raise SystemExit(f"expected {key} of {name} events to add up to "
+                             f"{total}, found {found}")
+    names = {event.get("args", {}).get("name") for event in metadata}
+    for name in args.metadata:
+        if name not in names:
+            raise SystemExit(f"no {name} metadata")
+    for pattern in args.absent:
+        left = glob.glob(pattern)
+        if left:
+            raise SystemExit(f"{left} left behind")
+    print(f"{len(files)} files, {len(events)} events")
+    # a rerun of the test must not count these again
+    for filename in files:
+        os.remove(filename)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,101 @@
+import argparse
+import glob
+import gzip
+import json
+import os
+from multiprocessing import get_context
+
+# Forks many short lived multiprocessing workers under LD_PRELOAD. Every
+# worker must end up in a trace file of its own: no events of the parent
+# buffer repeated in a child, no interleaved writes and one file per pid.
+# The start event of every worker names its parent as ppid and the event
+# the parent forked in as p_idx.
+# Run once to trace and again with --check to verify the traces.
+
+parser = argparse.ArgumentParser(prog="DFTracer fork stress test")
+parser.add_argument("--data_dir", default="./data", type=str)
+parser.add_argument("--log_file", default=os.getenv("DFTRACER_LOG_FILE"),
+                    type=str, help="DFTRACER_LOG_FILE of the traced run")
+parser.add_argument("--tasks", default=2000, type=int,
+                    help="Number of tasks, each in a new worker process")
+parser.add_argument("--processes", default=16, type=int)
+parser.add_argument("--writes", default=4, type=int,
+                    help="Writes per task")
+parser.add_argument("--check", action="store_true",
+                    help="Verify the traces of a previous run")
+args = parser.parse_args()
+
+
+def task(index):
+    path = f"{args.data_dir}/fork_stress_{index % 64}.dat"
+    fd = os.open(path, os.O_WRONLY | os.O_CREAT, 0o644)
+    for _ in range(args.writes):
+        os.write(fd, b"x" * 64)
+    os.close(fd)
+    return os.getpid()
+
+
+def read_events(filename):
+    opener = gzip.open if filename.endswith(".gz") else open
+    with opener(filename, "rt") as trace:
+        for line in trace:
+            line = line.strip()
+            if line in ("", "[", "]"):
+                continue
+            yield json.loads(line)
+
+
+def check():
+    files = glob.glob(f"{args.log_file}*.pfw*")
+    owners = {}
+    ids = {}
+    parents = []
+    writes = 0
+    for filename in files:
+        pids = set()
+        for event in read_events(filename):
+            if event.get("ph") == "M":
+                continue
+            pids.add(event["pid"])
+            ids.setdefault(event["pid"], set()).add(event.get("id"))
+            event_args = event.get("args", {})
+            # every event carries p_idx with metadata on, only the start
+            # of a traced child names a ppid
+            if event.get("name") == "start" and "ppid" in event_args:
+                parents.append((event["pid"], event_args["ppid"],
+                                event_args["p_idx"]))
+            if event.get("name") == "write" and event.get("cat") == "POSIX":
+                writes += 1
+        if len(pids) > 1:
+            raise SystemExit(f"{filename} has events of pids {sorted(pids)}")
+        for pid in pids:
+            if pid in owners:
+                raise SystemExit(f"pid {pid} in {owners[pid]} and {filename}")
+            owners[pid] = filename
+    for pid, ppid, p_idx in parents:
+        if ppid == pid or ppid not in owners:
+            raise SystemExit(f"pid {pid} has untraced parent {ppid}")
+        if p_idx >= 0 and p_idx not in ids[ppid]:
+            raise SystemExit(f"pid {pid} forked from unknown event {p_idx}")
+    if len(parents) < len(owners) - 1:
+        raise SystemExit(f"only {len(parents)} of {len(owners)} processes "
+                         "record their parent")
+    expected = args.tasks * args.writes
+    print(f"{len(files)} files, {len(owners)} pids, {writes} writes")
+    if writes != expected:
+        raise SystemExit(f"expected {expected} writes, found {writes}")
+
+
+def main():
+    if args.check:
+        check()
+        return
+    os.makedirs(args.data_dir, exist_ok=True)
+    context = get_context("fork")
+    with context.Pool(args.processes, maxtasksperchild=1) as pool:
+        pids = pool.map(task, range(args.tasks), chunksize=1)
+    print(f"{args.tasks} tasks in {len(set(pids))} worker processes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Runs a traced command while dftracer_service collects its events through
+# the shared memory rings and waits until the service wrote its trace.
+# Only the command is preloaded, the service takes DFTRACER_LOG_FILE from
+# SERVICE_LOG_FILE.
+#
+# usage: run_with_service.sh SERVICE LOG_DIR SERVICE_LOG_FILE PRELOAD CMD...
+service=$1
+log_dir=$2
+service_log_file=$3
+preload=$4
+shift 4
+
+announce=/dev/shm/dftracer-service.$(id -u)
+if [[ -e "$announce" ]]; then
+  echo "a dftracer_service of this user is running already"
+  exit 1
+fi
+
+DFTRACER_LOG_FILE=$service_log_file "$service" start "$log_dir"
+for i in $(seq 100); do
+  [[ -e "$announce" ]] && break
+  sleep 0.1
+done
+if [[ ! -e "$announce" ]]; then
+  echo "dftracer_service did not start"
+  exit 1
+fi
+pid=$(cat "$log_dir/dftracer_server.pid")
+
+DFTRACER_WRITER_BACKEND=SHM LD_PRELOAD=$preload "$@"
+status=$?
+
+"$service" stop "$log_dir"
+# the trace is complete once the service drained the rings and exited
+for i in $(seq 300); do
+  kill -0 "$pid" 2> /dev/null || break
+  sleep 0.1
+done
+if kill -0 "$pid" 2> /dev/null; then
+  echo "dftracer_service did not stop"
+  exit 1
+fi
+exit $status